@@ -0,0 +1,755 @@
+/*
+    Benchmark of ll_sizeof_serialized, ll_serialize, ll_deserialize, ll_scan and
+ll_template_serialize.
+
+    Every result is printed as one JSON object in "results" array, so output of
+two commits can be compared by scripts. Throughput is calculated for message
+bytes (not for serialized bytes), cycles are reference cycles read with rdtsc
+on x86 and are reported as null on other architectures.
+
+    Matrices:
+    - kernel: sizeof, serialize, deserialize, scan (one serialized message in buffer),
+      template (the same message serialized through cache, every call is a hit),
+      stream (many messages received by chunks of "chunk" bytes, remainder of
+      every chunk is parsed again with the next chunk, as receivers do);
+    - framing and checksum: all modes of ll_message_info_t;
+    - message size: 8 B .. 4 MB;
+    - escape density: 0%, 1%, 10% and 100% of message bytes equal to control bytes
+      (100% is examples 4.2-4.4 from ll_protocol.h);
+    - chunk: 1 B .. 64 KB (stream kernel only);
+    - corruption: probability of random byte change in serialized stream
+      (stream kernel only), "frames_ok" shows how many messages were recovered.
+
+    Goodput kernel sends stream of 64 bytes messages through simulated noisy channel
+(see ll_bench_channel.h: bit flips, lost and inserted bytes, bursts) and parses it
+by chunks of 4 KB with every resync strategy:
+    - deserialize: ll_deserialize, parsing continues from "remainder" after error;
+    - decoder: ll_decoder_push, unescaped "begin byte" inside of message starts new one.
+"frames_good" is quantity of parsed messages which are equal to sent ones, "recovered"
+is its part of sent messages and "good_frames_per_s" is goodput. Damaged stream depends
+only on --seed.
+
+    On Linux every result also has "counters" object with hardware cycles,
+instructions, branch misses and L1 data cache misses per message byte, read with
+perf_event_open (see ll_bench_perf.h). Counters which are not available are null.
+
+Build (from repository root, target "ll_bench"):
+    cmake -S . -B build && cmake --build build --target ll_bench
+
+Usage:
+    ll_bench [--quick] [--no-perf] [--min-time SECONDS] [--kernel NAME] [--seed N] > result.json
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_protocol.h"
+#include "ll_template.h"
+#include "ll_bench_perf.h"
+#include "ll_bench_channel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define LL_BENCH_RDTSC
+#endif
+
+#define LL_BENCH_BEGIN_BYTE  0xAA
+#define LL_BENCH_REJECT_BYTE 0xCC
+#define LL_BENCH_END_BYTE    0xBB
+
+//size of serialized byte stream used by stream kernel
+#define LL_BENCH_STREAM_SIZE ((size_t)4 * 1024 * 1024)
+#define LL_BENCH_STREAM_SIZE_QUICK ((size_t)256 * 1024)
+
+
+typedef struct
+{
+    double      min_time;
+    bool        quick;
+    const char* kernel;
+    size_t      stream_size;
+    bool        first_result;
+    uint64_t    random;
+    uint64_t    seed;
+    ll_bench_perf_t perf;
+} ll_bench_t;
+
+typedef struct
+{
+    double   seconds;
+    uint64_t cycles;
+    size_t   iterations;
+    size_t   frames;
+    size_t   frames_ok;
+    size_t   frames_good;
+} ll_bench_measure_t;
+
+typedef struct
+{
+    const char*              name;
+    ll_bench_channel_model_t model;
+} ll_bench_channel_case_t;
+
+//messages which were sent, parsed message is good if it is equal to sent one
+typedef struct
+{
+    const uint8_t* data;
+    size_t         frames;
+} ll_bench_sent_t;
+
+
+static const size_t ll_bench_sizes[] = { 8, 64, 512, 4096, 65536, 1048576, 4194304 };
+static const double ll_bench_densities[] = { 0.0, 0.01, 0.1, 1.0 };
+static const size_t ll_bench_chunks[] = { 1, 16, 256, 4096, 65536 };
+static const double ll_bench_corruptions[] = { 0.0, 0.00001, 0.0001, 0.001 };
+
+static const ll_bench_channel_case_t ll_bench_channels[] =
+{
+    { "bit_flip",      { 0.00001, 0.0,    0.0,    0.0,      0  } },
+    { "bit_flip_high", { 0.0001,  0.0,    0.0,    0.0,      0  } },
+    { "drop",          { 0.0,     0.0001, 0.0,    0.0,      0  } },
+    { "insert",        { 0.0,     0.0,    0.0001, 0.0,      0  } },
+    { "burst",         { 0.0,     0.0,    0.0,    0.00001,  32 } },
+    { "mixed",         { 0.00001, 0.00001, 0.00001, 0.000001, 32 } }
+};
+static const char* const ll_bench_strategies[] = { "deserialize", "decoder" };
+
+//kernels which are measured by ll_bench_message
+static const char* const ll_bench_message_kernels[] = { "sizeof", "serialize", "deserialize", "scan", "template" };
+
+//all kernels which can be selected by --kernel
+static const char* const ll_bench_kernels[] =
+{
+    "sizeof", "serialize", "deserialize", "scan", "template", "stream", "goodput"
+};
+
+static const char* const ll_bench_framing_names[LL_FRAMING_ENUM_SIZE] = { "reject", "cobs", "xor" };
+static const char* const ll_bench_checksum_names[LL_CHECKSUM_ENUM_SIZE] = { "none", "crc32c" };
+
+#define LL_BENCH_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+
+static double ll_bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t ll_bench_cycles(void)
+{
+#ifdef LL_BENCH_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//xorshift64*, benchmark must be reproducible so rand() is not used
+static uint64_t ll_bench_random(ll_bench_t* bench)
+{
+    bench->random ^= bench->random >> 12;
+    bench->random ^= bench->random << 25;
+    bench->random ^= bench->random >> 27;
+    return bench->random * 2685821657736338717ull;
+}
+
+static double ll_bench_random_unit(ll_bench_t* bench)
+{
+    return (double)(ll_bench_random(bench) >> 11) / (double)(1ull << 53);
+}
+
+static void ll_bench_fill(ll_bench_t* bench, ll_message_info_t msg_info, double density, uint8_t* data)
+{
+    const uint8_t control[3] = { msg_info.begin_byte, msg_info.reject_byte, msg_info.end_byte };
+    for(size_t i = 0; i < msg_info.size; i++)
+    {
+        if(density > 0.0 && ll_bench_random_unit(bench) < density)
+        {
+            data[i] = control[ll_bench_random(bench) % 3];
+            continue;
+        }
+        do
+        {
+            data[i] = (uint8_t)ll_bench_random(bench);
+        }
+        while(   data[i] == msg_info.begin_byte
+              || data[i] == msg_info.reject_byte
+              || data[i] == msg_info.end_byte);
+    }
+}
+
+static bool ll_bench_selected(const ll_bench_t* bench, const char* kernel)
+{
+    return !bench->kernel || strcmp(bench->kernel, kernel) == 0;
+}
+
+static void ll_bench_report(ll_bench_t* bench,
+                            const char* kernel,
+                            ll_message_info_t msg_info,
+                            double density,
+                            size_t chunk,
+                            double corruption,
+                            size_t bytes,
+                            const ll_bench_measure_t* measure)
+{
+    double total = (double)bytes * (double)measure->iterations;
+    printf("%s\n    {\"kernel\": \"%s\", \"framing\": \"%s\", \"checksum\": \"%s\", "
+           "\"size\": %zu, \"density\": %g, \"chunk\": %zu, \"corruption\": %g, "
+           "\"bytes\": %.0f, \"seconds\": %.6f, \"gb_per_s\": %.4f, ",
+           bench->first_result ? "" : ",",
+           kernel,
+           ll_bench_framing_names[msg_info.framing],
+           ll_bench_checksum_names[msg_info.checksum],
+           msg_info.size,
+           density,
+           chunk,
+           corruption,
+           total,
+           measure->seconds,
+           total / measure->seconds * 1e-9);
+    if(measure->cycles)
+    {
+        printf("\"cycles_per_byte\": %.4f", (double)measure->cycles / total);
+    }
+    else
+    {
+        printf("\"cycles_per_byte\": null");
+    }
+    printf(", \"frames\": %zu, \"frames_ok\": %zu, \"counters\": {", measure->frames, measure->frames_ok);
+    ll_bench_perf_print(&bench->perf, total, stdout);
+    printf("}}");
+    bench->first_result = false;
+    fflush(stdout);
+}
+
+//message kernels are repeated until "min_time" passes
+static void ll_bench_message(ll_bench_t* bench, ll_message_info_t msg_info, double density)
+{
+    uint8_t* data = malloc(msg_info.size);
+    uint8_t* serialized = malloc(ll_sizeof_serialized_max(msg_info));
+    uint8_t* parsed = malloc(msg_info.size);
+    ll_template_cache_t cache;
+    size_t cache_memory = (msg_info.size + ll_sizeof_serialized_max(msg_info) + 64) * LL_TEMPLATE_WAYS;
+    if(!data || !serialized || !parsed || ll_template_cache_init(&cache, msg_info, cache_memory) != LL_STATUS_SUCCESS)
+    {
+        free(data);
+        free(serialized);
+        free(parsed);
+        return;
+    }
+
+    ll_bench_fill(bench, msg_info, density, data);
+    size_t serialized_size = ll_sizeof_serialized(msg_info, data);
+    ll_serialize(msg_info, data, serialized);
+
+    const char* const* kernels = ll_bench_message_kernels;
+    for(size_t k = 0; k < LL_BENCH_COUNT(ll_bench_message_kernels); k++)
+    {
+        if(!ll_bench_selected(bench, kernels[k]))
+        {
+            continue;
+        }
+
+        ll_bench_measure_t measure = { 0 };
+        volatile size_t sink = 0;
+        ll_bench_perf_start(&bench->perf);
+        double begin = ll_bench_now();
+        uint64_t cycles = ll_bench_cycles();
+        do
+        {
+            //one batch is about 1 MB of message bytes, so time is read rarely
+            size_t batch = 1 + ((size_t)1 << 20) / (msg_info.size + 1);
+            for(size_t i = 0; i < batch; i++)
+            {
+                size_t remainder = 0;
+                ll_frame_scan_t frame;
+                switch(k)
+                {
+                case 0:
+                    sink += ll_sizeof_serialized(msg_info, data);
+                    break;
+                case 1:
+                    ll_serialize(msg_info, data, serialized);
+                    break;
+                case 2:
+                    measure.frames++;
+                    if(ll_deserialize(msg_info, serialized, serialized_size, parsed, &remainder) == LL_STATUS_SUCCESS)
+                    {
+                        measure.frames_ok++;
+                    }
+                    break;
+                case 3:
+                    measure.frames++;
+                    if(ll_scan(msg_info, serialized, serialized_size, &frame, &remainder) == LL_STATUS_SUCCESS)
+                    {
+                        measure.frames_ok++;
+                    }
+                    break;
+                default:
+                    ll_template_serialize(&cache, data, serialized);
+                    break;
+                }
+            }
+            measure.iterations += batch;
+            measure.seconds = ll_bench_now() - begin;
+        }
+        while(measure.seconds < bench->min_time);
+        measure.cycles = ll_bench_cycles() - cycles;
+        ll_bench_perf_stop(&bench->perf);
+        (void)sink;
+
+        ll_bench_report(bench, kernels[k], msg_info, density, 0, 0.0, msg_info.size, &measure);
+    }
+
+    ll_template_cache_destroy(&cache);
+    free(data);
+    free(serialized);
+    free(parsed);
+}
+
+//builds stream of serialized messages, returns its size
+static size_t ll_bench_build_stream(ll_bench_t* bench,
+                                    ll_message_info_t msg_info,
+                                    double density,
+                                    double corruption,
+                                    uint8_t* stream,
+                                    uint8_t* sent,
+                                    size_t* frames)
+{
+    uint8_t* data = malloc(msg_info.size);
+    size_t size = 0;
+    size_t max = ll_sizeof_serialized_max(msg_info);
+    *frames = 0;
+    if(!data)
+    {
+        return 0;
+    }
+
+    while(size + max <= bench->stream_size)
+    {
+        ll_bench_fill(bench, msg_info, density, data);
+        if(sent)
+        {
+            //the first bytes are number of message, so parsed message is compared with sent one
+            for(size_t i = 0; i < msg_info.size && i < sizeof(uint32_t); i++)
+            {
+                data[i] = (uint8_t)(*frames >> (i * 8));
+            }
+            memcpy(sent + *frames * msg_info.size, data, msg_info.size);
+        }
+        ll_serialize(msg_info, data, stream + size);
+        size += ll_sizeof_serialized(msg_info, data);
+        (*frames)++;
+    }
+    if(corruption > 0.0)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            if(ll_bench_random_unit(bench) < corruption)
+            {
+                stream[i] = (uint8_t)ll_bench_random(bench);
+            }
+        }
+    }
+
+    free(data);
+    return size;
+}
+
+static bool ll_bench_good(ll_message_info_t msg_info, const ll_bench_sent_t* sent, const uint8_t* parsed)
+{
+    size_t frame = 0;
+    for(size_t i = 0; i < msg_info.size && i < sizeof(uint32_t); i++)
+    {
+        frame |= (size_t)parsed[i] << (i * 8);
+    }
+    return frame < sent->frames && memcmp(parsed, sent->data + frame * msg_info.size, msg_info.size) == 0;
+}
+
+//receiver gets stream by chunks, appends every chunk to unparsed remainder and
+//parses all messages from the buffer
+static void ll_bench_stream_pass(ll_message_info_t msg_info,
+                                 const uint8_t* stream,
+                                 size_t stream_size,
+                                 size_t chunk,
+                                 uint8_t* buffer,
+                                 uint8_t* parsed,
+                                 const ll_bench_sent_t* sent,
+                                 ll_bench_measure_t* measure)
+{
+    size_t buffered = 0;
+    for(size_t received = 0; received < stream_size; received += chunk)
+    {
+        size_t size = stream_size - received < chunk ? stream_size - received : chunk;
+        memcpy(buffer + buffered, stream + received, size);
+        buffered += size;
+
+        size_t position = 0;
+        while(position < buffered)
+        {
+            size_t remainder = 0;
+            ll_status_t status = ll_deserialize(msg_info, buffer + position, buffered - position, parsed, &remainder);
+            if(status == LL_STATUS_NO_MESSAGE)
+            {
+                position = buffered;
+                break;
+            }
+            if(status == LL_STATUS_NO_ENOUGH_BYTES)
+            {
+                position += remainder;
+                break;
+            }
+            measure->frames++;
+            if(status == LL_STATUS_SUCCESS)
+            {
+                measure->frames_ok++;
+                if(sent && ll_bench_good(msg_info, sent, parsed))
+                {
+                    measure->frames_good++;
+                }
+            }
+            if(status == LL_STATUS_SUCCESS && remainder == 0)
+            {
+                position = buffered;
+                break;
+            }
+            position += remainder ? remainder : 1;
+        }
+
+        memmove(buffer, buffer + position, buffered - position);
+        buffered -= position;
+    }
+}
+
+static void ll_bench_stream(ll_bench_t* bench,
+                            ll_message_info_t msg_info,
+                            double density,
+                            size_t chunk,
+                            double corruption)
+{
+    size_t buffer_size = bench->stream_size + chunk;
+    uint8_t* stream = malloc(bench->stream_size);
+    uint8_t* buffer = malloc(buffer_size);
+    uint8_t* parsed = malloc(msg_info.size);
+    if(!stream || !buffer || !parsed)
+    {
+        free(stream);
+        free(buffer);
+        free(parsed);
+        return;
+    }
+
+    size_t frames = 0;
+    size_t stream_size = ll_bench_build_stream(bench, msg_info, density, corruption, stream, NULL, &frames);
+    ll_bench_measure_t measure = { 0 };
+    double begin = ll_bench_now();
+    uint64_t cycles = ll_bench_cycles();
+    ll_bench_measure_t pass;
+    ll_bench_perf_start(&bench->perf);
+    do
+    {
+        memset(&pass, 0, sizeof(pass));
+        ll_bench_stream_pass(msg_info, stream, stream_size, chunk, buffer, parsed, NULL, &pass);
+        measure.iterations++;
+        measure.seconds = ll_bench_now() - begin;
+    }
+    while(measure.seconds < bench->min_time);
+    measure.cycles = ll_bench_cycles() - cycles;
+    ll_bench_perf_stop(&bench->perf);
+    //counters are reported for one pass, "frames" is quantity of sent messages
+    measure.frames = frames;
+    measure.frames_ok = pass.frames_ok;
+
+    size_t message_bytes = frames * msg_info.size;
+    ll_bench_report(bench, "stream", msg_info, density, chunk, corruption, message_bytes, &measure);
+
+    free(stream);
+    free(buffer);
+    free(parsed);
+}
+
+//receiver gets stream by chunks and pushes them to decoder, nothing is parsed again
+static void ll_bench_decoder_pass(ll_message_info_t msg_info,
+                                  const uint8_t* stream,
+                                  size_t stream_size,
+                                  size_t chunk,
+                                  uint8_t* parsed,
+                                  const ll_bench_sent_t* sent,
+                                  ll_bench_measure_t* measure)
+{
+    ll_decoder_t decoder;
+    ll_decoder_init(&decoder, msg_info, parsed);
+    for(size_t received = 0; received < stream_size; received += chunk)
+    {
+        const uint8_t* data = stream + received;
+        size_t size = stream_size - received < chunk ? stream_size - received : chunk;
+        while(size > 0)
+        {
+            size_t consumed;
+            if(ll_decoder_push(&decoder, data, size, &consumed))
+            {
+                measure->frames_ok++;
+                if(sent && ll_bench_good(msg_info, sent, parsed))
+                {
+                    measure->frames_good++;
+                }
+            }
+            data += consumed;
+            size -= consumed;
+        }
+    }
+}
+
+static void ll_bench_report_goodput(ll_bench_t* bench,
+                                    const char* strategy,
+                                    ll_message_info_t msg_info,
+                                    const ll_bench_channel_case_t* channel,
+                                    size_t bytes,
+                                    const ll_bench_measure_t* measure)
+{
+    double total = (double)bytes * (double)measure->iterations;
+    printf("%s\n    {\"kernel\": \"goodput\", \"strategy\": \"%s\", \"framing\": \"%s\", "
+           "\"checksum\": \"%s\", \"size\": %zu, \"channel\": \"%s\", \"seed\": %llu, "
+           "\"bytes\": %.0f, \"seconds\": %.6f, \"gb_per_s\": %.4f, "
+           "\"frames\": %zu, \"frames_ok\": %zu, \"frames_good\": %zu, "
+           "\"recovered\": %.6f, \"good_frames_per_s\": %.0f, \"counters\": {",
+           bench->first_result ? "" : ",",
+           strategy,
+           ll_bench_framing_names[msg_info.framing],
+           ll_bench_checksum_names[msg_info.checksum],
+           msg_info.size,
+           channel->name,
+           (unsigned long long)bench->seed,
+           total,
+           measure->seconds,
+           total / measure->seconds * 1e-9,
+           measure->frames,
+           measure->frames_ok,
+           measure->frames_good,
+           measure->frames ? (double)measure->frames_good / (double)measure->frames : 0.0,
+           (double)measure->frames_good * (double)measure->iterations / measure->seconds);
+    ll_bench_perf_print(&bench->perf, total, stdout);
+    printf("}}");
+    bench->first_result = false;
+    fflush(stdout);
+}
+
+static void ll_bench_goodput(ll_bench_t* bench, ll_message_info_t msg_info, const ll_bench_channel_case_t* channel)
+{
+    const size_t chunk = 4096;
+    //every serialized message has at least "begin byte", message and "end byte"
+    size_t max_frames = bench->stream_size / (msg_info.size + 2);
+    uint8_t* stream = malloc(bench->stream_size);
+    uint8_t* damaged = malloc(bench->stream_size * 2);
+    uint8_t* buffer = malloc(bench->stream_size * 2 + chunk);
+    uint8_t* sent_data = malloc(max_frames * msg_info.size + 1);
+    uint8_t* parsed = malloc(msg_info.size);
+    if(!stream || !damaged || !buffer || !sent_data || !parsed)
+    {
+        free(stream);
+        free(damaged);
+        free(buffer);
+        free(sent_data);
+        free(parsed);
+        return;
+    }
+
+    //stream doesn't depend on kernels which were run before
+    bench->random = bench->seed;
+    size_t frames = 0;
+    size_t stream_size = ll_bench_build_stream(bench, msg_info, 0.01, 0.0, stream, sent_data, &frames);
+    ll_bench_channel_t simulator;
+    ll_bench_channel_init(&simulator, channel->model, bench->seed);
+    size_t damaged_size = ll_bench_channel_apply(&simulator, stream, stream_size, damaged);
+    ll_bench_sent_t sent = { sent_data, frames };
+
+    for(size_t s = 0; s < LL_BENCH_COUNT(ll_bench_strategies); s++)
+    {
+        ll_bench_measure_t measure = { 0 };
+        ll_bench_measure_t pass;
+        ll_bench_perf_start(&bench->perf);
+        double begin = ll_bench_now();
+        do
+        {
+            memset(&pass, 0, sizeof(pass));
+            if(s == 0)
+            {
+                ll_bench_stream_pass(msg_info, damaged, damaged_size, chunk, buffer, parsed, NULL, &pass);
+            }
+            else
+            {
+                ll_bench_decoder_pass(msg_info, damaged, damaged_size, chunk, parsed, NULL, &pass);
+            }
+            measure.iterations++;
+            measure.seconds = ll_bench_now() - begin;
+        }
+        while(measure.seconds < bench->min_time);
+        ll_bench_perf_stop(&bench->perf);
+
+        //parsed messages are compared with sent ones in separate pass, so comparing is not measured
+        memset(&pass, 0, sizeof(pass));
+        if(s == 0)
+        {
+            ll_bench_stream_pass(msg_info, damaged, damaged_size, chunk, buffer, parsed, &sent, &pass);
+        }
+        else
+        {
+            ll_bench_decoder_pass(msg_info, damaged, damaged_size, chunk, parsed, &sent, &pass);
+        }
+        measure.frames = frames;
+        measure.frames_ok = pass.frames_ok;
+        measure.frames_good = pass.frames_good;
+        ll_bench_report_goodput(bench, ll_bench_strategies[s], msg_info, channel, damaged_size, &measure);
+    }
+
+    free(stream);
+    free(damaged);
+    free(buffer);
+    free(sent_data);
+    free(parsed);
+}
+
+static void ll_bench_usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [--quick] [--no-perf] [--min-time SECONDS] [--kernel NAME] [--seed N]\n"
+            "kernels:",
+            name);
+    for(size_t k = 0; k < LL_BENCH_COUNT(ll_bench_kernels); k++)
+    {
+        fprintf(stderr, "%s %s", k ? "," : "", ll_bench_kernels[k]);
+    }
+    fprintf(stderr, "\n");
+}
+
+static bool ll_bench_kernel_known(const char* kernel)
+{
+    for(size_t k = 0; k < LL_BENCH_COUNT(ll_bench_kernels); k++)
+    {
+        if(strcmp(ll_bench_kernels[k], kernel) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    ll_bench_t bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.min_time = 0.05;
+    bench.stream_size = LL_BENCH_STREAM_SIZE;
+    bench.first_result = true;
+    bench.seed = 0x9E3779B97F4A7C15ull;
+    bool perf = true;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--quick") == 0)
+        {
+            bench.quick = true;
+        }
+        else if(strcmp(argv[i], "--no-perf") == 0)
+        {
+            perf = false;
+        }
+        else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            bench.min_time = strtod(argv[++i], NULL);
+        }
+        else if(strcmp(argv[i], "--kernel") == 0 && i + 1 < argc)
+        {
+            bench.kernel = argv[++i];
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            //0 is not valid state of xorshift
+            bench.seed = strtoull(argv[++i], NULL, 0);
+            if(bench.seed == 0)
+            {
+                bench.seed = 1;
+            }
+        }
+        else
+        {
+            ll_bench_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(bench.kernel && !ll_bench_kernel_known(bench.kernel))
+    {
+        ll_bench_usage(argv[0]);
+        return 1;
+    }
+    bench.random = bench.seed;
+    if(bench.quick)
+    {
+        bench.min_time = 0.005;
+        bench.stream_size = LL_BENCH_STREAM_SIZE_QUICK;
+    }
+
+    bool counters = ll_bench_perf_open(&bench.perf, perf);
+    printf("{\n  \"benchmark\": \"ll_protocol\",\n  \"counters\": %s,\n  \"results\": [",
+           counters ? "true" : "false");
+
+    for(int framing = 0; framing < LL_FRAMING_ENUM_SIZE; framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            ll_message_info_t msg_info =
+            {
+                0,
+                LL_BENCH_BEGIN_BYTE,
+                LL_BENCH_REJECT_BYTE,
+                LL_BENCH_END_BYTE,
+                (ll_framing_t)framing,
+                (ll_checksum_t)checksum
+            };
+
+            for(size_t s = 0; s < LL_BENCH_COUNT(ll_bench_sizes); s++)
+            {
+                msg_info.size = ll_bench_sizes[s];
+                for(size_t d = 0; d < LL_BENCH_COUNT(ll_bench_densities); d++)
+                {
+                    ll_bench_message(&bench, msg_info, ll_bench_densities[d]);
+                }
+            }
+
+            if(ll_bench_selected(&bench, "goodput"))
+            {
+                msg_info.size = 64;
+                for(size_t c = 0; c < LL_BENCH_COUNT(ll_bench_channels); c++)
+                {
+                    ll_bench_goodput(&bench, msg_info, &ll_bench_channels[c]);
+                }
+            }
+
+            if(!ll_bench_selected(&bench, "stream"))
+            {
+                continue;
+            }
+            //stream kernel uses typical message size, chunking and corruption are changed
+            msg_info.size = 64;
+            for(size_t c = 0; c < LL_BENCH_COUNT(ll_bench_chunks); c++)
+            {
+                for(size_t d = 0; d < LL_BENCH_COUNT(ll_bench_densities); d++)
+                {
+                    ll_bench_stream(&bench, msg_info, ll_bench_densities[d], ll_bench_chunks[c], 0.0);
+                }
+            }
+            for(size_t c = 1; c < LL_BENCH_COUNT(ll_bench_corruptions); c++)
+            {
+                ll_bench_stream(&bench, msg_info, 0.01, 4096, ll_bench_corruptions[c]);
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+    ll_bench_perf_close(&bench.perf);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "ll_bench_channel.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+
+//xorshift64*, the same generator as in benchmark
+static uint64_t ll_bench_channel_random(ll_bench_channel_t* channel)
+{
+    channel->random ^= channel->random >> 12;
+    channel->random ^= channel->random << 25;
+    channel->random ^= channel->random >> 27;
+    return channel->random * 2685821657736338717ull;
+}
+
+static double ll_bench_channel_unit(ll_bench_channel_t* channel)
+{
+    return (double)(ll_bench_channel_random(channel) >> 11) / (double)(1ull << 53);
+}
+
+//returns true with probability "p", generator is not called for disabled errors
+static bool ll_bench_channel_event(ll_bench_channel_t* channel, double p)
+{
+    return p > 0.0 && ll_bench_channel_unit(channel) < p;
+}
+
+void ll_bench_channel_init(ll_bench_channel_t* channel, ll_bench_channel_model_t model, uint64_t seed)
+{
+    channel->model = model;
+    //several flips in one byte are counted as one
+    channel->byte_flip = model.bit_flip > 0.0 ? 1.0 - pow(1.0 - model.bit_flip, 8.0) : 0.0;
+    channel->random = seed ? seed : 0x9E3779B97F4A7C15ull;
+    channel->burst_left = 0;
+}
+
+size_t ll_bench_channel_apply(ll_bench_channel_t* channel, const uint8_t* in, size_t size, uint8_t* out)
+{
+    size_t received = 0;
+    for(size_t i = 0; i < size; i++)
+    {
+        if(ll_bench_channel_event(channel, channel->model.insert))
+        {
+            out[received++] = (uint8_t)ll_bench_channel_random(channel);
+        }
+        if(ll_bench_channel_event(channel, channel->model.drop))
+        {
+            continue;
+        }
+        if(channel->burst_left == 0 && ll_bench_channel_event(channel, channel->model.burst))
+        {
+            channel->burst_left = channel->model.burst_length;
+        }
+        if(channel->burst_left > 0)
+        {
+            channel->burst_left--;
+            out[received++] = (uint8_t)ll_bench_channel_random(channel);
+            continue;
+        }
+
+        uint8_t byte = in[i];
+        if(ll_bench_channel_event(channel, channel->byte_flip))
+        {
+            byte ^= (uint8_t)(1u << (ll_bench_channel_random(channel) % 8));
+        }
+        out[received++] = byte;
+    }
+    return received;
+}
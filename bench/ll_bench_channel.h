@@ -0,0 +1,60 @@
+/*
+    Simulator of noisy channel for benchmark: errors are applied to serialized byte
+stream before it is parsed.
+
+    Errors (every probability is independent, 0 disables error):
+    - bit flip: every bit is inverted with probability "bit_flip";
+    - drop: every byte is lost with probability "drop";
+    - insertion: random byte is inserted before every byte with probability "insert";
+    - burst: with probability "burst" every byte starts burst of "burst_length" bytes
+      which are replaced by random bytes (like noise on the line).
+
+    Simulator uses its own xorshift64* generator, so the same seed and model always
+give the same damaged stream. Stream can be damaged by parts, bursts continue from
+one part to the next one.
+*/
+
+#ifndef LL_BENCH_CHANNEL_H
+#define LL_BENCH_CHANNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef struct
+{
+    double bit_flip;     //probability of inverted bit
+    double drop;         //probability of lost byte
+    double insert;       //probability of inserted random byte
+    double burst;        //probability of burst start
+    size_t burst_length; //quantity of random bytes in burst
+} ll_bench_channel_model_t;
+
+typedef struct
+{
+    ll_bench_channel_model_t model;
+    double   byte_flip;  //probability of at least one inverted bit in byte
+    uint64_t random;
+    size_t   burst_left; //quantity of bytes left in the current burst
+} ll_bench_channel_t;
+
+
+/**
+ * @brief This function initializes channel.
+ * @param channel channel
+ * @param model errors of channel
+ * @param seed seed of random generator, 0 is replaced by another constant
+ */
+void ll_bench_channel_init(ll_bench_channel_t* channel, ll_bench_channel_model_t model, uint64_t seed);
+
+/**
+ * @brief This function passes part of byte stream through channel.
+ * @param channel channel
+ * @param in sent bytes
+ * @param size quantity of sent bytes
+ * @param out area of memory with size of size*2 where received bytes will be putted
+ * @returns quantity of received bytes
+ */
+size_t ll_bench_channel_apply(ll_bench_channel_t* channel, const uint8_t* in, size_t size, uint8_t* out);
+
+#endif // LL_BENCH_CHANNEL_H
@@ -0,0 +1,145 @@
+#define _DEFAULT_SOURCE
+
+#include "ll_bench_perf.h"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+static const char* const ll_bench_perf_names[LL_BENCH_PERF_ENUM_SIZE] =
+{
+    "hw_cycles_per_byte",
+    "instructions_per_byte",
+    "branch_misses_per_byte",
+    "l1d_misses_per_byte"
+};
+
+#ifdef __linux__
+static int ll_bench_perf_open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    //counters can be multiplexed if there are not enough of them, values are scaled then
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+bool ll_bench_perf_open(ll_bench_perf_t* perf, bool enabled)
+{
+    bool result = false;
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        perf->fd[i] = -1;
+        perf->value[i] = 0;
+        perf->valid[i] = false;
+    }
+    if(!enabled)
+    {
+        return false;
+    }
+
+#ifdef __linux__
+    perf->fd[LL_BENCH_PERF_CYCLES] =
+        ll_bench_perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perf->fd[LL_BENCH_PERF_INSTRUCTIONS] =
+        ll_bench_perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perf->fd[LL_BENCH_PERF_BRANCH_MISSES] =
+        ll_bench_perf_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    perf->fd[LL_BENCH_PERF_L1D_MISSES] =
+        ll_bench_perf_open_counter(PERF_TYPE_HW_CACHE,
+                                   PERF_COUNT_HW_CACHE_L1D
+                                   | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                   | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        result = result || perf->fd[i] >= 0;
+    }
+#endif
+    return result;
+}
+
+void ll_bench_perf_start(ll_bench_perf_t* perf)
+{
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        perf->valid[i] = false;
+#ifdef __linux__
+        if(perf->fd[i] >= 0)
+        {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+}
+
+void ll_bench_perf_stop(ll_bench_perf_t* perf)
+{
+#ifdef __linux__
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        if(perf->fd[i] >= 0)
+        {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        //value, time enabled, time running
+        uint64_t data[3];
+        if(perf->fd[i] < 0 || read(perf->fd[i], data, sizeof(data)) != (ssize_t)sizeof(data) || data[2] == 0)
+        {
+            continue;
+        }
+        perf->value[i] = data[2] < data[1]
+                         ? (uint64_t)((double)data[0] * (double)data[1] / (double)data[2])
+                         : data[0];
+        perf->valid[i] = true;
+    }
+#else
+    (void)perf;
+#endif
+}
+
+void ll_bench_perf_print(const ll_bench_perf_t* perf, double bytes, FILE* file)
+{
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+        if(perf->valid[i] && bytes > 0.0)
+        {
+            fprintf(file, "%s\"%s\": %.4f", i ? ", " : "", ll_bench_perf_names[i], (double)perf->value[i] / bytes);
+        }
+        else
+        {
+            fprintf(file, "%s\"%s\": null", i ? ", " : "", ll_bench_perf_names[i]);
+        }
+    }
+}
+
+void ll_bench_perf_close(ll_bench_perf_t* perf)
+{
+    for(int i = 0; i < LL_BENCH_PERF_ENUM_SIZE; i++)
+    {
+#ifdef __linux__
+        if(perf->fd[i] >= 0)
+        {
+            close(perf->fd[i]);
+        }
+#endif
+        perf->fd[i] = -1;
+        perf->valid[i] = false;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+    Hardware performance counters for benchmark, read with perf_event_open on Linux.
+
+    Every counter is opened separately, so if some of them are not supported
+(virtual machines, perf_event_paranoid, other operating systems) the others
+are still measured. Unavailable counters are reported as null.
+*/
+
+#ifndef LL_BENCH_PERF_H
+#define LL_BENCH_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+typedef enum
+{
+    LL_BENCH_PERF_CYCLES,        //CPU cycles
+    LL_BENCH_PERF_INSTRUCTIONS,  //retired instructions
+    LL_BENCH_PERF_BRANCH_MISSES, //mispredicted branches
+    LL_BENCH_PERF_L1D_MISSES,    //L1 data cache read misses
+    LL_BENCH_PERF_ENUM_SIZE      //enum size
+} ll_bench_perf_counter_t;
+
+typedef struct
+{
+    int      fd[LL_BENCH_PERF_ENUM_SIZE];
+    uint64_t value[LL_BENCH_PERF_ENUM_SIZE];
+    bool     valid[LL_BENCH_PERF_ENUM_SIZE];
+} ll_bench_perf_t;
+
+
+/**
+ * @brief This function opens counters for the calling thread. Counters which can't
+ * be opened are marked as unavailable.
+ * @param perf counters
+ * @param enabled if false all counters are marked as unavailable
+ * @returns true if at least one counter is available
+ */
+bool ll_bench_perf_open(ll_bench_perf_t* perf, bool enabled);
+
+/**
+ * @brief This function resets and starts all available counters.
+ * @param perf counters
+ */
+void ll_bench_perf_start(ll_bench_perf_t* perf);
+
+/**
+ * @brief This function stops counters and reads their values to perf->value.
+ * Counter is marked as invalid in perf->valid if it can't be read.
+ * @param perf counters
+ */
+void ll_bench_perf_stop(ll_bench_perf_t* perf);
+
+/**
+ * @brief This function prints counters divided by "bytes" as JSON object members
+ * (for example "instructions_per_byte": 1.5), unavailable counters are printed as null.
+ * @param perf counters
+ * @param bytes quantity of processed bytes
+ * @param file output file
+ */
+void ll_bench_perf_print(const ll_bench_perf_t* perf, double bytes, FILE* file);
+
+/**
+ * @brief This function closes counters.
+ * @param perf counters
+ */
+void ll_bench_perf_close(ll_bench_perf_t* perf);
+
+#endif // LL_BENCH_PERF_H
@@ -0,0 +1,38 @@
+/*
+    Atomic and aligned members of structures which are shared by C and C++ code.
+C11 _Atomic and _Alignas can't be compiled as C++, so in C++ std::atomic and alignas
+are used instead. For lock-free types they have the same size and alignment in GCC
+and Clang, so structure has the same layout in C and C++ translation units.
+
+    <atomic> contains templates, so it is included with C++ linkage and this header
+can be included from extern "C" block of other headers.
+
+Example:
+    typedef struct
+    {
+        LL_ALIGNAS(64) LL_ATOMIC(size_t) head;
+    } queue_t;
+*/
+
+#ifndef LL_ATOMIC_H
+#define LL_ATOMIC_H
+
+#ifdef __cplusplus
+
+extern "C++" {
+#include <atomic>
+}
+
+#define LL_ATOMIC(type) std::atomic<type>
+#define LL_ALIGNAS(alignment) alignas(alignment)
+
+#else
+
+#include <stdatomic.h>
+
+#define LL_ATOMIC(type) _Atomic type
+#define LL_ALIGNAS(alignment) _Alignas(alignment)
+
+#endif // __cplusplus
+
+#endif // LL_ATOMIC_H
@@ -0,0 +1,710 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_capture.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LL_CAPTURE_MAGIC "LLCAPTR1"
+#define LL_CAPTURE_MAGIC_SIZE 8
+#define LL_CAPTURE_SEGMENT_MAGIC "LLSG"
+#define LL_CAPTURE_SEGMENT_HEADER 24
+
+//maximal size of two varints of record
+#define LL_CAPTURE_RECORD_HEADER 20
+
+//hash table of compressor, positions of the last 4 bytes sequences
+#define LL_CAPTURE_HASH_BITS 12
+#define LL_CAPTURE_MIN_MATCH 4
+#define LL_CAPTURE_MAX_OFFSET 65535
+
+
+static void ll_capture_put32(uint8_t* out, uint32_t value)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        out[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static void ll_capture_put64(uint8_t* out, uint64_t value)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        out[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static uint32_t ll_capture_get32(const uint8_t* in)
+{
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static uint64_t ll_capture_get64(const uint8_t* in)
+{
+    return (uint64_t)ll_capture_get32(in) | (uint64_t)ll_capture_get32(in + 4) << 32;
+}
+
+static size_t ll_capture_put_varint(uint8_t* out, uint64_t value)
+{
+    size_t size = 0;
+    do
+    {
+        out[size] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if(value)
+        {
+            out[size] |= 0x80;
+        }
+        size++;
+    }
+    while(value);
+    return size;
+}
+
+//reads varint from "*in" which is not beyond "end", returns false if varint is broken
+static bool ll_capture_get_varint(const uint8_t** in, const uint8_t* end, uint64_t* value)
+{
+    *value = 0;
+    for(unsigned shift = 0; shift < 64 && *in < end; shift += 7)
+    {
+        uint8_t byte = *(*in)++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t ll_capture_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+//writes length which doesn't fit to 4 bits of token
+static uint8_t* ll_capture_put_length(uint8_t* out, size_t length)
+{
+    for(; length >= 255; length -= 255)
+    {
+        *out++ = 255;
+    }
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+//writes one sequence: literals and match (match_length == 0 for the last sequence),
+//returns NULL if it doesn't fit before "out_end"
+static uint8_t* ll_capture_put_sequence(uint8_t* out,
+                                        const uint8_t* out_end,
+                                        const uint8_t* literals,
+                                        size_t literals_length,
+                                        size_t offset,
+                                        size_t match_length)
+{
+    size_t match_code = match_length ? match_length - LL_CAPTURE_MIN_MATCH : 0;
+    size_t worst = 1 + literals_length / 255 + 1 + literals_length + 2 + match_code / 255 + 1;
+    if((size_t)(out_end - out) < worst)
+    {
+        return NULL;
+    }
+
+    uint8_t* token = out++;
+    *token = (uint8_t)((literals_length < 15 ? literals_length : 15) << 4);
+    if(literals_length >= 15)
+    {
+        out = ll_capture_put_length(out, literals_length - 15);
+    }
+    memcpy(out, literals, literals_length);
+    out += literals_length;
+
+    if(match_length)
+    {
+        *token |= (uint8_t)(match_code < 15 ? match_code : 15);
+        *out++ = (uint8_t)offset;
+        *out++ = (uint8_t)(offset >> 8);
+        if(match_code >= 15)
+        {
+            out = ll_capture_put_length(out, match_code - 15);
+        }
+    }
+    return out;
+}
+
+//returns compressed size, 0 if compressed data is not smaller than "size"
+static size_t ll_capture_compress(const uint8_t* in, size_t size, uint8_t* out)
+{
+    uint32_t table[1 << LL_CAPTURE_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    uint8_t* out_begin = out;
+    const uint8_t* out_end = out + size - 1;
+    size_t anchor = 0;
+    size_t i = 0;
+    while(i + LL_CAPTURE_MIN_MATCH <= size)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, in + i, sizeof(sequence));
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LL_CAPTURE_HASH_BITS);
+        //positions are stored plus one, 0 means empty
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t)(i + 1);
+
+        if(candidate == 0
+           || i - (candidate - 1) > LL_CAPTURE_MAX_OFFSET
+           || memcmp(in + candidate - 1, in + i, LL_CAPTURE_MIN_MATCH) != 0)
+        {
+            i++;
+            continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = LL_CAPTURE_MIN_MATCH;
+        while(i + length < size && in[match + length] == in[i + length])
+        {
+            length++;
+        }
+        out = ll_capture_put_sequence(out, out_end, in + anchor, i - anchor, i - match, length);
+        if(!out)
+        {
+            return 0;
+        }
+        i += length;
+        anchor = i;
+    }
+
+    out = ll_capture_put_sequence(out, out_end, in + anchor, size - anchor, 0, 0);
+    return out ? (size_t)(out - out_begin) : 0;
+}
+
+static bool ll_capture_get_length(const uint8_t** in, const uint8_t* end, size_t* length)
+{
+    uint8_t byte;
+    do
+    {
+        if(*in == end)
+        {
+            return false;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    }
+    while(byte == 255);
+    return true;
+}
+
+//returns false if compressed data is corrupted or its size is not "size"
+static bool ll_capture_decompress(const uint8_t* in, size_t in_size, uint8_t* out, size_t size)
+{
+    const uint8_t* in_end = in + in_size;
+    size_t position = 0;
+    while(in < in_end)
+    {
+        uint8_t token = *in++;
+        size_t literals_length = token >> 4;
+        if(literals_length == 15 && !ll_capture_get_length(&in, in_end, &literals_length))
+        {
+            return false;
+        }
+        if(literals_length > (size_t)(in_end - in) || literals_length > size - position)
+        {
+            return false;
+        }
+        memcpy(out + position, in, literals_length);
+        in += literals_length;
+        position += literals_length;
+
+        //the last sequence has only literals
+        if(in == in_end)
+        {
+            break;
+        }
+        if(in_end - in < 2)
+        {
+            return false;
+        }
+        size_t offset = (size_t)in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t match_length = token & 0x0F;
+        if(match_length == 15 && !ll_capture_get_length(&in, in_end, &match_length))
+        {
+            return false;
+        }
+        match_length += LL_CAPTURE_MIN_MATCH;
+        if(offset == 0 || offset > position || match_length > size - position)
+        {
+            return false;
+        }
+        //match can overlap with itself, so it is copied byte by byte
+        for(size_t j = 0; j < match_length; j++)
+        {
+            out[position + j] = out[position + j - offset];
+        }
+        position += match_length;
+    }
+    return position == size;
+}
+
+static bool ll_capture_reserve(ll_capture_writer_t* writer, size_t size)
+{
+    if(size <= writer->segment_capacity)
+    {
+        return true;
+    }
+    uint8_t* segment = realloc(writer->segment, size);
+    if(!segment)
+    {
+        return false;
+    }
+    writer->segment = segment;
+    uint8_t* compressed = realloc(writer->compressed, size);
+    if(!compressed)
+    {
+        return false;
+    }
+    writer->compressed = compressed;
+    writer->segment_capacity = size;
+    return true;
+}
+
+//finds the end of the last segment which was written completely, returns false
+//if file is not capture file or segment which is not the torn tail of file is corrupted
+static bool ll_capture_complete_end(int fd, off_t* end)
+{
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        return false;
+    }
+    size_t file_size = (size_t)st.st_size;
+
+    //magic which was written partly is written again
+    uint8_t header[LL_CAPTURE_SEGMENT_HEADER];
+    size_t magic_size = file_size < LL_CAPTURE_MAGIC_SIZE ? file_size : LL_CAPTURE_MAGIC_SIZE;
+    if(pread(fd, header, magic_size, 0) != (ssize_t)magic_size
+       || memcmp(header, LL_CAPTURE_MAGIC, magic_size) != 0)
+    {
+        return false;
+    }
+    if(file_size < LL_CAPTURE_MAGIC_SIZE)
+    {
+        *end = 0;
+        return true;
+    }
+
+    //segments are checked the same way as by reader (see ll_capture_next_segment), only
+    //segment which runs past the end of file was torn by writer, any other broken segment
+    //means that file is corrupted and complete segments after it must not be cut off
+    size_t offset = LL_CAPTURE_MAGIC_SIZE;
+    while(offset < file_size)
+    {
+        size_t left = file_size - offset;
+        size_t header_size = left < LL_CAPTURE_SEGMENT_HEADER ? left : LL_CAPTURE_SEGMENT_HEADER;
+        size_t magic_size = header_size < 4 ? header_size : 4;
+        if(   pread(fd, header, header_size, (off_t)offset) != (ssize_t)header_size
+           || memcmp(header, LL_CAPTURE_SEGMENT_MAGIC, magic_size) != 0)
+        {
+            return false;
+        }
+        if(header_size < LL_CAPTURE_SEGMENT_HEADER)
+        {
+            break;
+        }
+        size_t records_size = ll_capture_get32(header + 4);
+        size_t stored_size = ll_capture_get32(header + 8);
+        if(stored_size > records_size)
+        {
+            return false;
+        }
+        if(stored_size > left - LL_CAPTURE_SEGMENT_HEADER)
+        {
+            break;
+        }
+        offset += LL_CAPTURE_SEGMENT_HEADER + stored_size;
+    }
+    *end = (off_t)offset;
+    return true;
+}
+
+ll_status_t ll_capture_writer_open(ll_capture_writer_t* writer, const char* path)
+{
+    if(!writer || !path)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(writer, 0, sizeof(*writer));
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if(fd < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    //segment which was written partly (program stopped during fwrite) is cut off,
+    //otherwise reader would stop at it and never see appended segments
+    off_t end;
+    if(!ll_capture_complete_end(fd, &end) || ftruncate(fd, end) != 0 || lseek(fd, end, SEEK_SET) < 0)
+    {
+        close(fd);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    writer->file = fdopen(fd, "ab");
+    if(!writer->file)
+    {
+        close(fd);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    if(!ll_capture_reserve(writer, LL_CAPTURE_SEGMENT))
+    {
+        fclose(writer->file);
+        free(writer->segment);
+        free(writer->compressed);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    //segments are written by one fwrite, so buffer of stream is not needed
+    setvbuf(writer->file, NULL, _IONBF, 0);
+    if(end == 0
+       && fwrite(LL_CAPTURE_MAGIC, 1, LL_CAPTURE_MAGIC_SIZE, writer->file) != LL_CAPTURE_MAGIC_SIZE)
+    {
+        writer->failed = true;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_append(ll_capture_writer_t* writer, uint64_t timestamp, const uint8_t* data, size_t size)
+{
+    if(!writer || (!data && size > 0) || size > UINT32_MAX - LL_CAPTURE_RECORD_HEADER)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    if(writer->chunks > 0 && writer->segment_size + LL_CAPTURE_RECORD_HEADER + size > LL_CAPTURE_SEGMENT)
+    {
+        ll_capture_flush(writer);
+    }
+    if(!ll_capture_reserve(writer, writer->segment_size + LL_CAPTURE_RECORD_HEADER + size))
+    {
+        writer->failed = true;
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    if(timestamp < writer->last_timestamp)
+    {
+        timestamp = writer->last_timestamp;
+    }
+    if(writer->chunks == 0)
+    {
+        writer->first_timestamp = timestamp;
+        writer->last_timestamp = timestamp;
+    }
+
+    uint8_t* record = writer->segment + writer->segment_size;
+    record += ll_capture_put_varint(record, timestamp - writer->last_timestamp);
+    record += ll_capture_put_varint(record, size);
+    if(size > 0)
+    {
+        memcpy(record, data, size);
+    }
+    writer->segment_size = (size_t)(record + size - writer->segment);
+    writer->last_timestamp = timestamp;
+    writer->chunks++;
+    return writer->failed ? LL_STATUS_BAD_PARAMS : LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_flush(ll_capture_writer_t* writer)
+{
+    if(!writer)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    if(writer->chunks == 0)
+    {
+        return writer->failed ? LL_STATUS_BAD_PARAMS : LL_STATUS_SUCCESS;
+    }
+
+    size_t stored_size = ll_capture_compress(writer->segment, writer->segment_size, writer->compressed);
+    const uint8_t* stored = writer->compressed;
+    if(stored_size == 0)
+    {
+        stored_size = writer->segment_size;
+        stored = writer->segment;
+    }
+
+    uint8_t header[LL_CAPTURE_SEGMENT_HEADER];
+    memcpy(header, LL_CAPTURE_SEGMENT_MAGIC, 4);
+    ll_capture_put32(header + 4, (uint32_t)writer->segment_size);
+    ll_capture_put32(header + 8, (uint32_t)stored_size);
+    ll_capture_put32(header + 12, writer->chunks);
+    ll_capture_put64(header + 16, writer->first_timestamp);
+
+    if(!writer->failed
+       && (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)
+           || fwrite(stored, 1, stored_size, writer->file) != stored_size))
+    {
+        writer->failed = true;
+    }
+    writer->segment_size = 0;
+    writer->chunks = 0;
+
+    //segment bigger than LL_CAPTURE_SEGMENT was used for one big chunk
+    if(writer->segment_capacity > LL_CAPTURE_SEGMENT)
+    {
+        free(writer->segment);
+        free(writer->compressed);
+        writer->segment = malloc(LL_CAPTURE_SEGMENT);
+        writer->compressed = malloc(LL_CAPTURE_SEGMENT);
+        writer->segment_capacity = LL_CAPTURE_SEGMENT;
+        if(!writer->segment || !writer->compressed)
+        {
+            free(writer->segment);
+            free(writer->compressed);
+            writer->segment = NULL;
+            writer->compressed = NULL;
+            writer->segment_capacity = 0;
+        }
+    }
+    return writer->failed ? LL_STATUS_BAD_PARAMS : LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_writer_close(ll_capture_writer_t* writer)
+{
+    if(!writer)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_capture_flush(writer);
+    if(fclose(writer->file) != 0)
+    {
+        writer->failed = true;
+    }
+    free(writer->segment);
+    free(writer->compressed);
+    writer->file = NULL;
+    writer->segment = NULL;
+    writer->compressed = NULL;
+    return writer->failed ? LL_STATUS_BAD_PARAMS : LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_reader_open(ll_capture_reader_t* reader, const char* path)
+{
+    if(!reader || !path)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < LL_CAPTURE_MAGIC_SIZE)
+    {
+        close(fd);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    if(memcmp(mapping, LL_CAPTURE_MAGIC, LL_CAPTURE_MAGIC_SIZE) != 0)
+    {
+        munmap(mapping, size);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+    memset(reader, 0, sizeof(*reader));
+    reader->mapping = (const uint8_t*)mapping;
+    reader->mapping_size = size;
+    reader->offset = LL_CAPTURE_MAGIC_SIZE;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_capture_reader_close(ll_capture_reader_t* reader)
+{
+    if(!reader || !reader->mapping)
+    {
+        return;
+    }
+    munmap((void*)reader->mapping, reader->mapping_size);
+    free(reader->buffer);
+    reader->mapping = NULL;
+    reader->buffer = NULL;
+}
+
+//makes the next segment current
+static ll_status_t ll_capture_next_segment(ll_capture_reader_t* reader)
+{
+    const uint8_t* header = reader->mapping + reader->offset;
+    size_t left = reader->mapping_size - reader->offset;
+    if(left < LL_CAPTURE_SEGMENT_HEADER)
+    {
+        return LL_STATUS_NO_MESSAGE;
+    }
+    if(memcmp(header, LL_CAPTURE_SEGMENT_MAGIC, 4) != 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    size_t records_size = ll_capture_get32(header + 4);
+    size_t stored_size = ll_capture_get32(header + 8);
+    if(stored_size > left - LL_CAPTURE_SEGMENT_HEADER)
+    {
+        return LL_STATUS_NO_MESSAGE;
+    }
+    if(stored_size > records_size)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    const uint8_t* stored = header + LL_CAPTURE_SEGMENT_HEADER;
+    if(stored_size == records_size)
+    {
+        reader->records = stored;
+    }
+    else
+    {
+        if(records_size > reader->buffer_capacity)
+        {
+            uint8_t* buffer = realloc(reader->buffer, records_size);
+            if(!buffer)
+            {
+                return LL_STATUS_BAD_PARAMS;
+            }
+            reader->buffer = buffer;
+            reader->buffer_capacity = records_size;
+        }
+        if(!ll_capture_decompress(stored, stored_size, reader->buffer, records_size))
+        {
+            return LL_STATUS_BAD_PARAMS;
+        }
+        reader->records = reader->buffer;
+    }
+    reader->records_end = reader->records + records_size;
+    reader->chunks = ll_capture_get32(header + 12);
+    reader->timestamp = ll_capture_get64(header + 16);
+    reader->offset += LL_CAPTURE_SEGMENT_HEADER + stored_size;
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_next(ll_capture_reader_t* reader, uint64_t* timestamp, const uint8_t** data, size_t* size)
+{
+    if(!reader || !reader->mapping || !timestamp || !data || !size)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    while(reader->chunks == 0)
+    {
+        ll_status_t status = ll_capture_next_segment(reader);
+        if(status != LL_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    uint64_t delta;
+    uint64_t chunk_size;
+    if(!ll_capture_get_varint(&reader->records, reader->records_end, &delta)
+       || !ll_capture_get_varint(&reader->records, reader->records_end, &chunk_size)
+       || chunk_size > (uint64_t)(reader->records_end - reader->records))
+    {
+        reader->chunks = 0;
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    reader->timestamp += delta;
+    reader->chunks--;
+    *timestamp = reader->timestamp;
+    *data = reader->records;
+    *size = (size_t)chunk_size;
+    reader->records += chunk_size;
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_capture_replay(ll_capture_reader_t* reader,
+                              ll_decoder_t* decoder,
+                              ll_capture_replay_t mode,
+                              ll_latency_histogram_t* histogram,
+                              ll_capture_callback_t callback,
+                              void* context,
+                              ll_capture_stats_t* stats)
+{
+    if(!reader || !decoder || !stats || mode >= LL_CAPTURE_REPLAY_ENUM_SIZE)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    uint64_t begin = ll_capture_clock_ns();
+    uint64_t first_timestamp = 0;
+    ll_status_t status;
+    uint64_t timestamp;
+    const uint8_t* data;
+    size_t size;
+
+    while((status = ll_capture_next(reader, &timestamp, &data, &size)) == LL_STATUS_SUCCESS)
+    {
+        if(stats->chunks == 0)
+        {
+            first_timestamp = timestamp;
+        }
+        if(mode == LL_CAPTURE_REPLAY_REALTIME)
+        {
+            uint64_t target = begin + (timestamp - first_timestamp);
+            uint64_t now = ll_capture_clock_ns();
+            if(now < target)
+            {
+                struct timespec ts = {(time_t)(target / 1000000000u), (long)(target % 1000000000u)};
+                while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+                {
+                }
+            }
+            else if(now - target > stats->late_max_ns)
+            {
+                stats->late_max_ns = now - target;
+            }
+        }
+
+        uint64_t push_begin = histogram ? ll_latency_now() : 0;
+        uint64_t decode_begin = ll_capture_clock_ns();
+        stats->chunks++;
+        stats->bytes += size;
+        while(size > 0)
+        {
+            size_t consumed;
+            if(ll_decoder_push(decoder, data, size, &consumed))
+            {
+                stats->messages++;
+                if(histogram)
+                {
+                    ll_latency_record(histogram, ll_latency_now() - push_begin);
+                }
+                if(callback)
+                {
+                    callback(context, decoder->buffer);
+                }
+            }
+            data += consumed;
+            size -= consumed;
+        }
+        stats->decode_ns += ll_capture_clock_ns() - decode_begin;
+    }
+
+    stats->elapsed_ns = ll_capture_clock_ns() - begin;
+    return status == LL_STATUS_NO_MESSAGE ? LL_STATUS_SUCCESS : status;
+}
@@ -0,0 +1,211 @@
+/*
+    Capture file: byte stream saved as chunks in the same parts as it was received
+(one read() or one datagram is one chunk) with monotonic timestamps, and replay of
+capture through decoder.
+
+    File is append-only: 8 bytes "LLCAPTR1" and segments one after another. Chunks are
+collected to segment in memory (up to LL_CAPTURE_SEGMENT bytes) and segment is compressed
+and written by one fwrite when it is full or ll_capture_flush is called. If program
+stops, only the last unwritten segment is lost, and file can be opened for appending again
+(segment which was written partly is cut off by ll_capture_writer_open).
+
+    Segment (all numbers are little endian):
+    - header (24 bytes): "LLSG", size of records, size of stored data (it is equal to size
+      of records if data is not compressed), quantity of chunks (4 bytes each), timestamp
+      of the first chunk (8 bytes);
+    - records compressed with simple LZ77 (format of LZ4 block: token with lengths of
+      literals and match, literals, 2 bytes offset of match) or not compressed if
+      compression doesn't make them smaller.
+    Record of chunk is LEB128 varint of time from previous chunk of segment (0 for the
+first one), LEB128 varint of chunk size and bytes of chunk.
+
+    Replay pushes chunks to decoder (ll_decoder_push) in the same parts:
+    - LL_CAPTURE_REPLAY_FAST: as fast as possible, to benchmark decoder on real chunks;
+    - LL_CAPTURE_REPLAY_REALTIME: every chunk at the same time from the beginning of replay
+      as it was received from the beginning of capture, to test latency.
+
+Example:
+    //receiving thread
+    ll_capture_writer_open(&writer, "link.cap");
+    size = read(fd, buffer, sizeof(buffer));
+    ll_capture_append(&writer, now_ns, buffer, size);
+    ll_capture_writer_close(&writer);
+
+    //replay
+    ll_capture_reader_open(&reader, "link.cap");
+    ll_decoder_init(&decoder, msg_info, data);
+    ll_capture_replay(&reader, &decoder, LL_CAPTURE_REPLAY_FAST, NULL, callback, context, &stats);
+    ll_capture_reader_close(&reader);
+*/
+
+#ifndef LL_CAPTURE_H
+#define LL_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_latency.h"
+
+#include <stdio.h>
+
+
+//size of segment records, bigger chunk is written as the only chunk of segment
+#define LL_CAPTURE_SEGMENT ((size_t)1024 * 1024)
+
+typedef enum
+{
+    LL_CAPTURE_REPLAY_FAST,     //chunks are pushed without waiting
+    LL_CAPTURE_REPLAY_REALTIME, //chunks are pushed with the same intervals as received
+    LL_CAPTURE_REPLAY_ENUM_SIZE //enum size
+} ll_capture_replay_t;
+
+/**
+ * @brief Callback which is called for every parsed message.
+ * @param context context which was passed to ll_capture_replay
+ * @param data parsed message with size of msg_info.size, it is valid only during the call
+ */
+typedef void (*ll_capture_callback_t)(void* context, const uint8_t* data);
+
+typedef struct
+{
+    FILE*    file;
+    uint8_t* segment;         //records of segment
+    size_t   segment_size;
+    size_t   segment_capacity;
+    uint8_t* compressed;      //buffer with size of segment_capacity
+    uint32_t chunks;          //quantity of chunks in segment
+    uint64_t first_timestamp; //timestamp of the first chunk of segment
+    uint64_t last_timestamp;  //timestamp of the last appended chunk
+    bool     failed;          //writing or allocation has failed
+} ll_capture_writer_t;
+
+typedef struct
+{
+    const uint8_t* mapping;
+    size_t         mapping_size;
+    size_t         offset;           //offset of the next segment in file
+    uint8_t*       buffer;           //decompressed records
+    size_t         buffer_capacity;
+    const uint8_t* records;          //records of the current segment
+    const uint8_t* records_end;
+    uint32_t       chunks;           //quantity of chunks left in the current segment
+    uint64_t       timestamp;        //timestamp of the last read chunk
+} ll_capture_reader_t;
+
+typedef struct
+{
+    uint64_t chunks;
+    uint64_t bytes;
+    uint64_t messages;    //quantity of parsed messages (LL_STATUS_SUCCESS)
+    uint64_t elapsed_ns;  //time of whole replay
+    uint64_t decode_ns;   //time spent in decoder
+    uint64_t late_max_ns; //maximal delay of chunk from its time (LL_CAPTURE_REPLAY_REALTIME)
+} ll_capture_stats_t;
+
+
+/**
+ * @brief This function opens capture file for appending, file is created if it doesn't exist.
+ * If the last segment was written partly (it runs past the end of file), file is truncated
+ * to the end of the previous segment, so segments are appended after complete ones.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param path path of capture file,
+ * if path == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if file can't be opened,
+ * it is not capture file or it has corrupted segment which is not torn tail of file,
+ * file is not changed in this case)
+ */
+ll_status_t ll_capture_writer_open(ll_capture_writer_t* writer, const char* path);
+
+/**
+ * @brief This function appends chunk to the current segment, segment is written to file
+ * when it is full.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param timestamp time when chunk was received in nanoseconds of monotonic clock
+ * (for example CLOCK_MONOTONIC), timestamp less than previous one is saved as previous one
+ * @param data chunk,
+ * if data == NULL and size > 0 then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param size chunk size, it must be less than 4 GB
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if chunk can't be saved
+ */
+ll_status_t ll_capture_append(ll_capture_writer_t* writer, uint64_t timestamp, const uint8_t* data, size_t size);
+
+/**
+ * @brief This function writes the current segment to file even if it is not full.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if any write has failed
+ */
+ll_status_t ll_capture_flush(ll_capture_writer_t* writer);
+
+/**
+ * @brief This function writes the current segment, closes file and frees memory of writer.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if any write has failed
+ */
+ll_status_t ll_capture_writer_close(ll_capture_writer_t* writer);
+
+/**
+ * @brief This function maps capture file to memory for reading.
+ * @param reader reader,
+ * if reader == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param path path of capture file
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if file can't be mapped or it is
+ * not capture file
+ */
+ll_status_t ll_capture_reader_open(ll_capture_reader_t* reader, const char* path);
+
+/**
+ * @brief This function unmaps capture file and frees memory of reader.
+ * @param reader reader,
+ * if reader == NULL then function does nothing
+ */
+void ll_capture_reader_close(ll_capture_reader_t* reader);
+
+/**
+ * @brief This function reads the next chunk of capture.
+ * @param reader reader
+ * @param timestamp timestamp of chunk will be putted here
+ * @param data pointer to chunk will be putted here, chunk is valid until the next call
+ * @param size chunk size will be putted here
+ * @returns LL_STATUS_SUCCESS, LL_STATUS_NO_MESSAGE if there are no more chunks (segment
+ * which was written partly is ignored), LL_STATUS_BAD_PARAMS if file is corrupted
+ */
+ll_status_t ll_capture_next(ll_capture_reader_t* reader, uint64_t* timestamp, const uint8_t** data, size_t* size);
+
+/**
+ * @brief This function pushes all remaining chunks of capture to decoder.
+ * @param reader reader,
+ * if reader == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param decoder decoder initialized by ll_decoder_init,
+ * if decoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param mode replay mode,
+ * if mode is unknown then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param histogram histogram where time from the beginning of push of chunk to the end
+ * of parsing of every message is recorded (see ll_latency.h), it can be NULL
+ * @param callback callback for every parsed message, it can be NULL
+ * @param context context passed to "callback"
+ * @param stats statistics of replay will be putted here,
+ * if stats == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if capture is corrupted (chunks
+ * before corrupted segment are pushed)
+ */
+ll_status_t ll_capture_replay(
+    ll_capture_reader_t* reader,
+    ll_decoder_t* decoder,
+    ll_capture_replay_t mode,
+    ll_latency_histogram_t* histogram,
+    ll_capture_callback_t callback,
+    void* context,
+    ll_capture_stats_t* stats
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_CAPTURE_H
@@ -0,0 +1,41 @@
+#ifndef LL_CRC32C_H
+#define LL_CRC32C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ * @brief This function calculates CRC32C (Castagnoli polynomial) of "data". It uses
+ * SSE4.2 crc32 instruction if CPU supports it and slicing-by-8 tables otherwise.
+ *
+ * Pass 0 as "crc" for the first part of data and the previous result for the next
+ * parts, so ll_crc32c(ll_crc32c(0, a, a_size), b, b_size) is CRC32C of "a" followed by "b".
+ *
+ * @param crc CRC32C of previous data or 0
+ * @param data area of memory with size of "size",
+ * if data == NULL then function does nothing and returns "crc"
+ * @param size data size
+ * @returns CRC32C
+ */
+uint32_t ll_crc32c(uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * @brief This function calculates CRC32C of two parts of data from CRC32C of each part.
+ * It is used to calculate CRC32C of big data by parts in parallel.
+ * @param crc1 CRC32C of the first part
+ * @param crc2 CRC32C of the second part
+ * @param size2 size of the second part
+ * @returns CRC32C of the first part followed by the second part
+ */
+uint32_t ll_crc32c_combine(uint32_t crc1, uint32_t crc2, size_t size2);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_CRC32C_H
@@ -0,0 +1,433 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_delta.h"
+#include "ll_crc32c.h"
+
+#include <string.h>
+
+#define LL_DELTA_CHECKSUM_SIZE 4
+
+//the same as mask of escaped bytes in ll_protocol.c
+#define LL_DELTA_XOR_MASK 0x20
+
+//sequence number is 4 bytes little endian, so 2^32 frames must be lost in a row
+//before delta can be applied to wrong message
+#define LL_DELTA_SEQUENCE_SIZE 4
+
+//kind of frame and sequence number
+#define LL_DELTA_HEADER_SIZE (1 + LL_DELTA_SEQUENCE_SIZE)
+
+//maximal size of LEB128 number of size_t
+#define LL_DELTA_NUMBER_MAX 10
+
+//unchanged bytes between changed ones are sent in the same run if there are not more of them
+//than this quantity, because new run takes at least two bytes
+#define LL_DELTA_GAP 2
+
+
+static bool ll_delta_info_valid(ll_message_info_t msg_info)
+{
+    return ll_message_info_valid(msg_info) && msg_info.framing != LL_FRAMING_COBS;
+}
+
+static size_t ll_delta_trailer_size(ll_message_info_t msg_info)
+{
+    return msg_info.checksum == LL_CHECKSUM_CRC32C ? LL_DELTA_CHECKSUM_SIZE : 0;
+}
+
+static size_t ll_delta_put_number(uint8_t* data, size_t number)
+{
+    size_t size = 0;
+    while(number >= 0x80)
+    {
+        data[size++] = (uint8_t)(number | 0x80);
+        number >>= 7;
+    }
+    data[size++] = (uint8_t)number;
+    return size;
+}
+
+//returns false if number is not finished before "end"
+static bool ll_delta_get_number(const uint8_t** data, const uint8_t* end, size_t* number)
+{
+    *number = 0;
+    for(unsigned shift = 0; *data < end && shift < 8 * sizeof(size_t); shift += 7)
+    {
+        uint8_t byte = *(*data)++;
+        *number |= (size_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//returns position of the first byte from "i" which differs in "a" and "b"
+static size_t ll_delta_skip(const uint8_t* a, const uint8_t* b, size_t i, size_t size)
+{
+    for(; i + 8 <= size; i += 8)
+    {
+        uint64_t a_word;
+        uint64_t b_word;
+        memcpy(&a_word, a + i, 8);
+        memcpy(&b_word, b + i, 8);
+        if(a_word != b_word)
+        {
+            break;
+        }
+    }
+    for(; i < size && a[i] == b[i]; i++)
+    {
+    }
+    return i;
+}
+
+//puts runs of delta after header of body, returns size of body or 0 if it is not smaller than keyframe
+static size_t ll_delta_runs(const ll_delta_encoder_t* encoder, const uint8_t* data_in)
+{
+    size_t size = encoder->msg_info.size;
+    const uint8_t* previous = encoder->previous;
+    uint8_t* body = encoder->body;
+    size_t body_size = LL_DELTA_HEADER_SIZE;
+    size_t i = 0;
+
+    while(true)
+    {
+        size_t first = ll_delta_skip(data_in, previous, i, size);
+        if(first == size)
+        {
+            return body_size;
+        }
+        size_t last = first;
+        for(size_t j = first + 1; j < size && j - last <= LL_DELTA_GAP; j++)
+        {
+            if(data_in[j] != previous[j])
+            {
+                last = j;
+            }
+        }
+        size_t count = last - first + 1;
+        if(body_size + 2 * LL_DELTA_NUMBER_MAX + count >= LL_DELTA_HEADER_SIZE + size)
+        {
+            //exact size of numbers is checked only near the end
+            uint8_t numbers[2 * LL_DELTA_NUMBER_MAX];
+            size_t numbers_size = ll_delta_put_number(numbers, first - i);
+            numbers_size += ll_delta_put_number(numbers + numbers_size, count);
+            if(body_size + numbers_size + count >= LL_DELTA_HEADER_SIZE + size)
+            {
+                return 0;
+            }
+        }
+        body_size += ll_delta_put_number(body + body_size, first - i);
+        body_size += ll_delta_put_number(body + body_size, count);
+        for(size_t j = first; j <= last; j++)
+        {
+            body[body_size++] = data_in[j] ^ previous[j];
+        }
+        i = last + 1;
+    }
+}
+
+size_t ll_sizeof_delta_max(ll_message_info_t msg_info)
+{
+    if(!ll_delta_info_valid(msg_info))
+    {
+        return 0;
+    }
+    ll_message_info_t body_info = msg_info;
+    body_info.size = LL_DELTA_HEADER_SIZE + msg_info.size;
+    return ll_sizeof_serialized_max(body_info);
+}
+
+ll_status_t ll_delta_encoder_init(ll_delta_encoder_t* encoder, ll_message_info_t msg_info, uint64_t keyframe_interval)
+{
+    if(!encoder || !ll_delta_info_valid(msg_info) || keyframe_interval == 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->msg_info = msg_info;
+    encoder->keyframe_interval = keyframe_interval;
+    encoder->previous = malloc(msg_info.size + 1);
+    encoder->body = malloc(LL_DELTA_HEADER_SIZE + msg_info.size + 2 * LL_DELTA_NUMBER_MAX);
+    if(!encoder->previous || !encoder->body)
+    {
+        ll_delta_encoder_destroy(encoder);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_delta_encoder_destroy(ll_delta_encoder_t* encoder)
+{
+    if(!encoder)
+    {
+        return;
+    }
+    free(encoder->previous);
+    free(encoder->body);
+    encoder->previous = NULL;
+    encoder->body = NULL;
+}
+
+size_t ll_delta_serialize(ll_delta_encoder_t* encoder, const uint8_t* data_in, uint8_t* data_out)
+{
+    if(!encoder || !data_in || !data_out)
+    {
+        return 0;
+    }
+
+    size_t size = encoder->msg_info.size;
+    size_t body_size = 0;
+    bool keyframe =    !encoder->started
+                    || encoder->since_keyframe >= encoder->keyframe_interval;
+    if(!keyframe)
+    {
+        body_size = ll_delta_runs(encoder, data_in);
+        keyframe = body_size == 0;
+    }
+    if(keyframe)
+    {
+        encoder->body[0] = LL_DELTA_KEYFRAME;
+        memcpy(encoder->body + LL_DELTA_HEADER_SIZE, data_in, size);
+        body_size = LL_DELTA_HEADER_SIZE + size;
+        encoder->since_keyframe = 0;
+        encoder->keyframes++;
+    }
+    else
+    {
+        encoder->body[0] = LL_DELTA_DELTA;
+        encoder->since_keyframe++;
+        encoder->deltas++;
+    }
+    for(size_t i = 0; i < LL_DELTA_SEQUENCE_SIZE; i++)
+    {
+        encoder->body[1 + i] = (uint8_t)(encoder->sequence >> (8 * i));
+    }
+    encoder->sequence++;
+    encoder->started = true;
+    memcpy(encoder->previous, data_in, size);
+
+    //body is serialized as message of its size, so checksum is calculated for body
+    ll_message_info_t body_info = encoder->msg_info;
+    body_info.size = body_size;
+    return ll_serialize(body_info, encoder->body, data_out);
+}
+
+ll_status_t ll_delta_decoder_init(ll_delta_decoder_t* decoder, ll_message_info_t msg_info)
+{
+    if(!decoder || !ll_delta_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->msg_info = msg_info;
+    decoder->previous = malloc(msg_info.size + 1);
+    decoder->body = malloc(LL_DELTA_HEADER_SIZE + msg_info.size + ll_delta_trailer_size(msg_info));
+    if(!decoder->previous || !decoder->body)
+    {
+        ll_delta_decoder_destroy(decoder);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_delta_decoder_destroy(ll_delta_decoder_t* decoder)
+{
+    if(!decoder)
+    {
+        return;
+    }
+    free(decoder->previous);
+    free(decoder->body);
+    decoder->previous = NULL;
+    decoder->body = NULL;
+}
+
+//unescapes the next frame to decoder->body, "body_size" is valid only with LL_STATUS_SUCCESS
+static ll_status_t ll_delta_unescape(ll_delta_decoder_t* decoder,
+                                     const uint8_t* byte_stream,
+                                     size_t byte_stream_size,
+                                     size_t* body_size,
+                                     size_t* remainder)
+{
+    ll_message_info_t msg_info = decoder->msg_info;
+    const uint8_t mask = msg_info.framing == LL_FRAMING_XOR ? LL_DELTA_XOR_MASK : 0;
+    size_t body_max = LL_DELTA_HEADER_SIZE + msg_info.size + ll_delta_trailer_size(msg_info);
+
+    size_t begin_pos = 0;
+    for(; begin_pos < byte_stream_size; begin_pos++)
+    {
+        //in LL_FRAMING_REJECT mode "begin byte" after "reject byte" is a byte of message
+        if(   byte_stream[begin_pos] == msg_info.begin_byte
+           && (   msg_info.framing == LL_FRAMING_XOR
+               || begin_pos == 0
+               || byte_stream[begin_pos - 1] != msg_info.reject_byte))
+        {
+            break;
+        }
+    }
+    if(begin_pos == byte_stream_size)
+    {
+        *remainder = byte_stream_size;
+        return LL_STATUS_NO_MESSAGE;
+    }
+
+    size_t count = 0;
+    bool escaped = false;
+    for(size_t i = begin_pos + 1; i < byte_stream_size; i++)
+    {
+        uint8_t byte = byte_stream[i];
+        if(!escaped && byte == msg_info.end_byte)
+        {
+            *body_size = count;
+            *remainder = i == byte_stream_size - 1 ? 0 : i + 1;
+            return LL_STATUS_SUCCESS;
+        }
+        if(!escaped && byte == msg_info.begin_byte)
+        {
+            *remainder = i;
+            return LL_STATUS_MESSAGE_TOO_SHORT;
+        }
+        if(!escaped && byte == msg_info.reject_byte)
+        {
+            escaped = true;
+            continue;
+        }
+        if(count == body_max)
+        {
+            *remainder = i;
+            return LL_STATUS_MESSAGE_TOO_LONG;
+        }
+        decoder->body[count++] = escaped ? byte ^ mask : byte;
+        escaped = false;
+    }
+
+    *remainder = begin_pos;
+    return LL_STATUS_NO_ENOUGH_BYTES;
+}
+
+//applies runs of delta to decoder->previous, returns false if body is broken
+static bool ll_delta_apply(ll_delta_decoder_t* decoder, const uint8_t* runs, const uint8_t* end)
+{
+    size_t size = decoder->msg_info.size;
+    size_t i = 0;
+    while(runs < end)
+    {
+        size_t skip;
+        size_t count;
+        if(   !ll_delta_get_number(&runs, end, &skip)
+           || !ll_delta_get_number(&runs, end, &count)
+           || count == 0
+           || skip > size - i
+           || count > size - i - skip
+           || count > (size_t)(end - runs))
+        {
+            return false;
+        }
+        i += skip;
+        for(size_t j = 0; j < count; j++)
+        {
+            decoder->previous[i + j] ^= runs[j];
+        }
+        i += count;
+        runs += count;
+    }
+    return true;
+}
+
+//checks body of frame and applies it to decoder->previous
+static ll_status_t ll_delta_body(ll_delta_decoder_t* decoder, size_t body_size)
+{
+    size_t size = decoder->msg_info.size;
+    size_t trailer_size = ll_delta_trailer_size(decoder->msg_info);
+    const uint8_t* body = decoder->body;
+    if(body_size < LL_DELTA_HEADER_SIZE + trailer_size)
+    {
+        return LL_STATUS_MESSAGE_TOO_SHORT;
+    }
+    if(trailer_size)
+    {
+        body_size -= trailer_size;
+        uint32_t checksum = 0;
+        for(size_t i = 0; i < LL_DELTA_CHECKSUM_SIZE; i++)
+        {
+            checksum |= (uint32_t)body[body_size + i] << (8 * i);
+        }
+        if(checksum != ll_crc32c(0, body, body_size))
+        {
+            return LL_STATUS_CHECKSUM_FAILURE;
+        }
+    }
+
+    uint32_t sequence = 0;
+    for(size_t i = 0; i < LL_DELTA_SEQUENCE_SIZE; i++)
+    {
+        sequence |= (uint32_t)body[1 + i] << (8 * i);
+    }
+    if(body[0] == LL_DELTA_KEYFRAME)
+    {
+        if(body_size != LL_DELTA_HEADER_SIZE + size)
+        {
+            return LL_STATUS_MESSAGE_TOO_SHORT;
+        }
+        memcpy(decoder->previous, body + LL_DELTA_HEADER_SIZE, size);
+        decoder->has_reference = true;
+        decoder->sequence = sequence;
+        decoder->keyframes++;
+        return LL_STATUS_SUCCESS;
+    }
+    if(body[0] != LL_DELTA_DELTA)
+    {
+        return LL_STATUS_MESSAGE_TOO_SHORT;
+    }
+    if(!decoder->has_reference || sequence != decoder->sequence + 1)
+    {
+        //frame was lost, so the next deltas are not applied too
+        decoder->has_reference = false;
+        return LL_STATUS_NO_REFERENCE;
+    }
+    if(!ll_delta_apply(decoder, body + LL_DELTA_HEADER_SIZE, body + body_size))
+    {
+        //previous message can be changed by broken delta
+        decoder->has_reference = false;
+        return LL_STATUS_MESSAGE_TOO_SHORT;
+    }
+    decoder->sequence = sequence;
+    decoder->deltas++;
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_delta_deserialize(ll_delta_decoder_t* decoder,
+                                 const uint8_t* byte_stream,
+                                 size_t byte_stream_size,
+                                 uint8_t* data_out,
+                                 size_t* remainder)
+{
+    if(!decoder || !byte_stream || !data_out || !remainder)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    size_t body_size = 0;
+    ll_status_t status = ll_delta_unescape(decoder, byte_stream, byte_stream_size, &body_size, remainder);
+    if(status != LL_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    status = ll_delta_body(decoder, body_size);
+    if(status != LL_STATUS_SUCCESS)
+    {
+        if(*remainder == 0)
+        {
+            *remainder = byte_stream_size;
+        }
+        return status;
+    }
+    memcpy(data_out, decoder->previous, decoder->msg_info.size);
+    return LL_STATUS_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+    Delta mode for channels where consecutive messages differ in few bytes (slowly changing
+sensors, statuses). Messages have fixed size, so every message lines up byte for byte with
+the previous one: transmitter sends only XOR of message with the previous message, and
+receiver gets the message back by XORing it with the previous received message.
+
+    Every message is sent as frame with body of variable size:
+    - keyframe: LL_DELTA_KEYFRAME, sequence number, message;
+    - delta:    LL_DELTA_DELTA, sequence number, runs of XOR with the previous message.
+Sequence number is 4 bytes little endian.
+Run is quantity of unchanged bytes, quantity of changed bytes (both are LEB128 numbers)
+and changed bytes XORed with previous ones. Bytes after the last run are not changed.
+Body is framed the same way as message in ll_serialize (with msg_info.framing and
+msg_info.checksum, checksum is calculated for body), so frame of message without changes
+is only 7 bytes (plus checksum).
+
+    Keyframe is sent for the first message, after every "keyframe_interval" deltas and when
+delta would be bigger than message. Delta is applied by receiver only if its sequence number
+follows the sequence number of the previous received frame, otherwise (for example if frame
+was lost or damaged) deltas are rejected with LL_STATUS_NO_REFERENCE until the next keyframe,
+so "keyframe_interval" limits how long receiver stays without messages after one lost frame.
+
+    Only LL_FRAMING_REJECT and LL_FRAMING_XOR are supported, because in these modes frame of
+any size is parsed by unescaping bytes till "end byte".
+
+Example:
+    ll_delta_encoder_t encoder;
+    ll_delta_encoder_init(&encoder, msg_info, 100);
+    uint8_t* frame = malloc(ll_sizeof_delta_max(msg_info));
+    size_t frame_size = ll_delta_serialize(&encoder, sensors, frame);
+    write(fd, frame, frame_size);
+
+    ll_delta_decoder_t decoder;
+    ll_delta_decoder_init(&decoder, msg_info);
+    size_t remainder;
+    ll_status_t status = ll_delta_deserialize(&decoder, stream, stream_size, sensors, &remainder);
+*/
+
+#ifndef LL_DELTA_H
+#define LL_DELTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+
+//first byte of frame body
+#define LL_DELTA_KEYFRAME 0x00
+#define LL_DELTA_DELTA    0x01
+
+typedef struct
+{
+    ll_message_info_t msg_info;
+    uint8_t*          previous;          //the previous sent message
+    uint8_t*          body;              //body of frame before serializing
+    uint64_t          keyframe_interval; //maximal quantity of deltas after keyframe
+    uint64_t          since_keyframe;    //quantity of deltas after the last keyframe
+    uint32_t          sequence;          //sequence number of the next frame
+    bool              started;           //the first frame was sent
+    uint64_t          keyframes;         //quantity of sent keyframes
+    uint64_t          deltas;            //quantity of sent deltas
+} ll_delta_encoder_t;
+
+typedef struct
+{
+    ll_message_info_t msg_info;
+    uint8_t*          previous;          //the previous received message
+    uint8_t*          body;              //unescaped body of frame
+    uint32_t          sequence;          //sequence number of the previous received frame
+    bool              has_reference;     //deltas can be applied to "previous"
+    uint64_t          keyframes;         //quantity of received keyframes
+    uint64_t          deltas;            //quantity of received deltas
+} ll_delta_decoder_t;
+
+
+/**
+ * @brief This function is used to know how many bytes you need to reserve for frame
+ * (see ll_delta_serialize).
+ * @param msg_info message info
+ * @returns maximal size of frame, 0 if msg_info is not supported by ll_delta_encoder_init
+ */
+size_t ll_sizeof_delta_max(ll_message_info_t msg_info);
+
+/**
+ * @brief This function allocates memory of encoder.
+ * @param encoder encoder,
+ * if encoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info,
+ * if it is not valid (see ll_message_info_valid) or framing is LL_FRAMING_COBS then function
+ * does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param keyframe_interval keyframe is sent after this quantity of deltas,
+ * if keyframe_interval == 0 then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * (receiver would never get keyframe again after lost frame)
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_delta_encoder_init(ll_delta_encoder_t* encoder, ll_message_info_t msg_info, uint64_t keyframe_interval);
+
+/**
+ * @brief This function frees memory of encoder.
+ * @param encoder encoder,
+ * if encoder == NULL then function does nothing
+ */
+void ll_delta_encoder_destroy(ll_delta_encoder_t* encoder);
+
+/**
+ * @brief This function serializes keyframe or delta of "data_in" and puts the result to
+ * "data_out". After that "data_in" is the previous message for the next call.
+ * @param encoder encoder initialized by ll_delta_encoder_init,
+ * if encoder == NULL then function does nothing and returns 0
+ * @param data_in message with size of msg_info.size,
+ * if data_in == NULL then function does nothing and returns 0
+ * @param data_out area of memory with size that was returned by ll_sizeof_delta_max,
+ * if data_out == NULL then function does nothing and returns 0
+ * @returns quantity of bytes putted to "data_out", 0 if function did nothing
+ */
+size_t ll_delta_serialize(ll_delta_encoder_t* encoder, const uint8_t* data_in, uint8_t* data_out);
+
+/**
+ * @brief This function allocates memory of decoder.
+ * @param decoder decoder,
+ * if decoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info the same as in ll_delta_encoder_init
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_delta_decoder_init(ll_delta_decoder_t* decoder, ll_message_info_t msg_info);
+
+/**
+ * @brief This function frees memory of decoder.
+ * @param decoder decoder,
+ * if decoder == NULL then function does nothing
+ */
+void ll_delta_decoder_destroy(ll_delta_decoder_t* decoder);
+
+/**
+ * @brief This function parses the next frame of bytes stream and puts the whole message
+ * to "data_out". Statuses and "remainder" are the same as in ll_deserialize, except of
+ * size of frame which is not fixed: LL_STATUS_MESSAGE_TOO_LONG is returned if body is bigger
+ * than keyframe, LL_STATUS_MESSAGE_TOO_SHORT if body is broken (or if unescaped "begin byte"
+ * comes before "end byte", then "remainder" is position of that "begin byte").
+ * If delta can't be applied (see the top of this file) function returns
+ * LL_STATUS_NO_REFERENCE and "data_out" is not changed.
+ * @param decoder decoder initialized by ll_delta_decoder_init,
+ * if decoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param byte_stream the same as in ll_deserialize
+ * @param byte_stream_size byte stream size
+ * @param data_out area of memory with size of msg_info.size, it is changed only if
+ * function returns LL_STATUS_SUCCESS,
+ * if data_out == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param remainder the same as in ll_deserialize
+ * @returns status
+ */
+ll_status_t ll_delta_deserialize(
+    ll_delta_decoder_t* decoder,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    uint8_t* data_out,
+    size_t* remainder
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_DELTA_H
@@ -0,0 +1,258 @@
+#define _GNU_SOURCE
+
+#include "ll_epoll.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+//size of buffer where ready connection is read
+#define LL_EPOLL_READ_SIZE ((size_t)64 * 1024)
+
+//maximal quantity of events returned by one epoll_wait
+#define LL_EPOLL_EVENTS 256
+
+
+ll_status_t ll_epoll_init(ll_epoll_t* framer, ll_message_info_t msg_info, size_t connections_max, size_t batch_max)
+{
+    if(   !framer
+       || !ll_message_info_valid(msg_info)
+       || msg_info.size > UINT32_MAX
+       || connections_max == 0
+       || connections_max > UINT32_MAX
+       || connections_max > SIZE_MAX / (msg_info.size + 1)
+       || batch_max == 0
+       || batch_max > SIZE_MAX / (msg_info.size + 1)
+       || batch_max > SIZE_MAX / sizeof(ll_epoll_frame_t))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    memset(framer, 0, sizeof(*framer));
+    framer->msg_info = msg_info;
+    framer->connections_max = connections_max;
+    framer->batch_max = batch_max;
+
+    framer->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    framer->connections = malloc(connections_max * sizeof(*framer->connections));
+    framer->slab = malloc(connections_max * msg_info.size + 1);
+    framer->free = malloc(connections_max * sizeof(*framer->free));
+    framer->closed = malloc(connections_max * sizeof(*framer->closed));
+    framer->read_buffer = malloc(LL_EPOLL_READ_SIZE);
+    framer->batch = malloc(batch_max * sizeof(*framer->batch));
+    framer->batch_data = malloc(batch_max * msg_info.size + 1);
+    if(   framer->epoll_fd < 0
+       || !framer->connections
+       || !framer->slab
+       || !framer->free
+       || !framer->closed
+       || !framer->read_buffer
+       || !framer->batch
+       || !framer->batch_data)
+    {
+        ll_epoll_destroy(framer);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    //connections with small indexes are used first
+    for(size_t i = 0; i < connections_max; i++)
+    {
+        framer->connections[i].fd = -1;
+        framer->free[i] = (uint32_t)(connections_max - 1 - i);
+    }
+    framer->free_count = connections_max;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_epoll_destroy(ll_epoll_t* framer)
+{
+    if(!framer)
+    {
+        return;
+    }
+    if(framer->epoll_fd >= 0)
+    {
+        close(framer->epoll_fd);
+    }
+    free(framer->connections);
+    free(framer->slab);
+    free(framer->free);
+    free(framer->closed);
+    free(framer->read_buffer);
+    free(framer->batch);
+    free(framer->batch_data);
+    memset(framer, 0, sizeof(*framer));
+    framer->epoll_fd = -1;
+}
+
+ll_status_t ll_epoll_add(ll_epoll_t* framer, int fd, size_t* connection)
+{
+    if(!framer || fd < 0 || !connection || framer->free_count == 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint32_t index = framer->free[framer->free_count - 1];
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.u32 = index;
+    if(epoll_ctl(framer->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    framer->free_count--;
+
+    ll_epoll_connection_t* conn = &framer->connections[index];
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = fd;
+    conn->status = LL_STATUS_NO_MESSAGE;
+    if(framer->trackers)
+    {
+        ll_latency_end(&framer->trackers[index], false);
+    }
+    *connection = index;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_epoll_trace(ll_epoll_t* framer, ll_latency_tracker_t* trackers)
+{
+    if(framer)
+    {
+        framer->trackers = trackers;
+    }
+}
+
+static void ll_epoll_dispatch(ll_epoll_t* framer, ll_epoll_callback_t callback, void* context)
+{
+    if(framer->batch_count)
+    {
+        callback(context, framer->batch, framer->batch_count);
+        framer->batch_count = 0;
+    }
+
+    //closed connections are freed only after callback has seen them
+    for(size_t i = 0; i < framer->closed_count; i++)
+    {
+        framer->connections[framer->closed[i]].fd = -1;
+        framer->free[framer->free_count++] = framer->closed[i];
+    }
+    framer->closed_count = 0;
+}
+
+static void ll_epoll_put(ll_epoll_t* framer,
+                         uint32_t index,
+                         const uint8_t* data,
+                         ll_epoll_callback_t callback,
+                         void* context)
+{
+    if(framer->batch_count == framer->batch_max)
+    {
+        ll_epoll_dispatch(framer, callback, context);
+    }
+
+    ll_epoll_frame_t* frame = &framer->batch[framer->batch_count];
+    frame->connection = index;
+    frame->data = NULL;
+    if(data)
+    {
+        uint8_t* copy = framer->batch_data + framer->batch_count * framer->msg_info.size;
+        memcpy(copy, data, framer->msg_info.size);
+        frame->data = copy;
+    }
+    framer->batch_count++;
+}
+
+//reads connection until EAGAIN, returns false if connection was closed
+static bool ll_epoll_read(ll_epoll_t* framer, uint32_t index, ll_epoll_callback_t callback, void* context)
+{
+    ll_epoll_connection_t* conn = &framer->connections[index];
+
+    //decoder is expanded from compact state only while connection is read
+    ll_decoder_t decoder;
+    ll_decoder_init(&decoder, framer->msg_info, framer->slab + (size_t)index * framer->msg_info.size);
+    decoder.message_iter = conn->message_iter;
+    decoder.checksum = conn->checksum;
+    memcpy(decoder.trailer, conn->trailer, sizeof(decoder.trailer));
+    decoder.state = conn->state;
+    decoder.cobs_run = conn->cobs_run;
+    decoder.cobs_delimiter = conn->cobs_delimiter;
+    decoder.status = (ll_status_t)conn->status;
+    decoder.tracker = framer->trackers ? &framer->trackers[index] : NULL;
+
+    bool open = true;
+    for(;;)
+    {
+        ssize_t size = read(conn->fd, framer->read_buffer, LL_EPOLL_READ_SIZE);
+        if(size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if(size <= 0)
+        {
+            open = false;
+            break;
+        }
+
+        const uint8_t* data = framer->read_buffer;
+        while(size > 0)
+        {
+            size_t consumed;
+            if(ll_decoder_push(&decoder, data, (size_t)size, &consumed))
+            {
+                ll_epoll_put(framer, index, decoder.buffer, callback, context);
+            }
+            data += consumed;
+            size -= (ssize_t)consumed;
+        }
+    }
+
+    conn->message_iter = (uint32_t)decoder.message_iter;
+    conn->checksum = decoder.checksum;
+    memcpy(conn->trailer, decoder.trailer, sizeof(conn->trailer));
+    conn->state = decoder.state;
+    conn->cobs_run = decoder.cobs_run;
+    conn->cobs_delimiter = decoder.cobs_delimiter;
+    conn->status = (uint8_t)decoder.status;
+    return open;
+}
+
+int ll_epoll_run(ll_epoll_t* framer, int timeout, ll_epoll_callback_t callback, void* context)
+{
+    if(!framer || !callback)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct epoll_event events[LL_EPOLL_EVENTS];
+    int count = epoll_wait(framer->epoll_fd, events, LL_EPOLL_EVENTS, timeout);
+    if(count < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        uint32_t index = events[i].data.u32;
+        if(!ll_epoll_read(framer, index, callback, context))
+        {
+            epoll_ctl(framer->epoll_fd, EPOLL_CTL_DEL, framer->connections[index].fd, NULL);
+            ll_epoll_put(framer, index, NULL, callback, context);
+            framer->closed[framer->closed_count++] = index;
+        }
+    }
+    ll_epoll_dispatch(framer, callback, context);
+    return count;
+}
@@ -0,0 +1,153 @@
+/*
+    Event loop which parses messages from many non-blocking byte streams (for example
+TCP connections) with epoll in edge-triggered mode.
+
+    All connections use the same message info, so state of connection is only
+the state of its decoder (see ll_decoder_t) without message info and pointers:
+20 bytes, and states of all connections are in one array. Unfinished message of
+connection is stored in its slot of one big slab (msg_info.size bytes for every
+connection). When event comes, connection is read until EAGAIN into one shared
+read buffer and bytes are parsed directly from it.
+
+    Parsed messages are copied to batch and passed to callback together: once after
+all events returned by one epoll_wait are processed, or earlier if batch is full.
+Closing of connection (end of file or read error) is passed in batch too.
+
+Example:
+    ll_epoll_t framer;
+    ll_epoll_init(&framer, msg_info, 100000, 256);
+    ll_epoll_add(&framer, accepted_fd, &connection);
+
+    for(;;)
+    {
+        ll_epoll_run(&framer, -1, on_frames, context);
+    }
+*/
+
+#ifndef LL_EPOLL_H
+#define LL_EPOLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_latency.h"
+
+
+typedef struct
+{
+    size_t         connection; //index of connection returned by ll_epoll_add
+    const uint8_t* data;       //parsed message, NULL if connection was closed
+} ll_epoll_frame_t;
+
+/**
+ * @brief Callback which is called for batch of parsed messages.
+ * @param context context which was passed to ll_epoll_run
+ * @param frames parsed messages in order of parsing, they are valid only during the call.
+ * Frame with data == NULL means that connection was closed (end of file or read error),
+ * it was removed from epoll and its index can be given to another connection after
+ * the call, file descriptor must be closed by callback.
+ * @param count quantity of frames
+ */
+typedef void (*ll_epoll_callback_t)(void* context, const ll_epoll_frame_t* frames, size_t count);
+
+//state of connection, it must be changed only by ll_epoll_* functions
+typedef struct
+{
+    int32_t  fd; //-1 if connection is not used
+    uint32_t message_iter;
+    uint32_t checksum;
+    uint8_t  trailer[4];
+    uint8_t  state;
+    uint8_t  cobs_run;
+    uint8_t  cobs_delimiter;
+    uint8_t  status; //status of the last ended message
+} ll_epoll_connection_t;
+
+typedef struct
+{
+    int                    epoll_fd;
+    ll_message_info_t      msg_info;
+    ll_epoll_connection_t* connections;
+    uint8_t*               slab;      //unfinished messages of connections
+    uint32_t*              free;      //stack of unused connections
+    size_t                 free_count;
+    size_t                 connections_max;
+    uint8_t*               read_buffer;
+    ll_epoll_frame_t*      batch;
+    uint8_t*               batch_data;
+    size_t                 batch_count;
+    size_t                 batch_max;
+    uint32_t*              closed;    //connections which are freed after batch is passed
+    size_t                 closed_count;
+    ll_latency_tracker_t*  trackers;  //trackers of connections, NULL if latency is not tracked
+} ll_epoll_t;
+
+
+/**
+ * @brief This function creates epoll instance and allocates states of connections.
+ * @param framer framer,
+ * if framer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info of all connections,
+ * if it is not valid or msg_info.size is bigger than UINT32_MAX then function does
+ * nothing and returns LL_STATUS_BAD_PARAMS
+ * @param connections_max maximal quantity of connections,
+ * if it is 0 or bigger than UINT32_MAX or messages of all connections don't fit into
+ * size_t (connections_max * (msg_info.size + 1) > SIZE_MAX) then function does nothing
+ * and returns LL_STATUS_BAD_PARAMS
+ * @param batch_max maximal quantity of frames passed to callback at once,
+ * if it is 0 or messages of batch don't fit into size_t then function does nothing
+ * and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if epoll can't be created
+ * or memory can't be allocated)
+ */
+ll_status_t ll_epoll_init(ll_epoll_t* framer, ll_message_info_t msg_info, size_t connections_max, size_t batch_max);
+
+/**
+ * @brief This function closes epoll instance and frees memory. File descriptors
+ * of connections are not closed.
+ * @param framer framer,
+ * if framer == NULL then function does nothing
+ */
+void ll_epoll_destroy(ll_epoll_t* framer);
+
+/**
+ * @brief This function makes file descriptor non-blocking and adds it to epoll.
+ * @param framer framer
+ * @param fd file descriptor
+ * @param connection pointer where index of connection will be putted
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (if there are already
+ * connections_max connections or fd can't be added to epoll)
+ */
+ll_status_t ll_epoll_add(ll_epoll_t* framer, int fd, size_t* connection);
+
+/**
+ * @brief This function sets trackers which record latencies of messages of connections
+ * (see ll_latency.h), timestamps are taken by decoder of connection when "begin byte"
+ * is parsed and when message is parsed. Pending message of tracker is dropped when
+ * its index is given to new connection.
+ * @param framer framer,
+ * if framer == NULL then function does nothing
+ * @param trackers array of connections_max trackers, tracker of connection is
+ * trackers[connection], NULL disables tracking
+ */
+void ll_epoll_trace(ll_epoll_t* framer, ll_latency_tracker_t* trackers);
+
+/**
+ * @brief This function waits for events, reads all ready connections and passes
+ * parsed messages to callback.
+ * @param framer framer
+ * @param timeout timeout of epoll_wait in milliseconds, -1 means infinite
+ * @param callback callback,
+ * if callback == NULL then function does nothing and returns -1
+ * @param context context passed to "callback"
+ * @returns quantity of events, -1 with errno if epoll_wait failed
+ */
+int ll_epoll_run(ll_epoll_t* framer, int timeout, ll_epoll_callback_t callback, void* context);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_EPOLL_H
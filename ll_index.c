@@ -0,0 +1,373 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_index.h"
+#include "ll_parallel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LL_INDEX_HEADER_SIZE 64
+#define LL_INDEX_MAGIC "LLINDEX1"
+
+//bits of varint used for status
+#define LL_INDEX_STATUS_BITS 3
+_Static_assert(LL_STATUS_ENUM_SIZE <= 1 << LL_INDEX_STATUS_BITS, "status doesn't fit into bits of index varint");
+
+//index file is written by many small varints
+#define LL_INDEX_FILE_BUFFER ((size_t)1024 * 1024)
+
+//frames which are not bigger are read to buffer on stack
+#define LL_INDEX_STACK_FRAME 4096
+
+
+static void ll_index_put64(uint8_t* out, uint64_t value)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        out[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static uint64_t ll_index_get64(const uint8_t* in)
+{
+    uint64_t value = 0;
+    for(int i = 0; i < 8; i++)
+    {
+        value |= (uint64_t)in[i] << (i * 8);
+    }
+    return value;
+}
+
+static void ll_index_write(ll_index_writer_t* writer, const void* data, size_t size)
+{
+    if(!writer->failed && fwrite(data, 1, size, writer->file) != size)
+    {
+        writer->failed = true;
+    }
+}
+
+//reads varint from "*in" which is not beyond "end", returns false if varint is broken
+static bool ll_index_varint(const uint8_t** in, const uint8_t* end, uint64_t* value)
+{
+    *value = 0;
+    for(unsigned shift = 0; shift < 64 && *in < end; shift += 7)
+    {
+        uint8_t byte = *(*in)++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+ll_status_t ll_index_writer_open(ll_index_writer_t* writer, ll_message_info_t msg_info, const char* path)
+{
+    if(!writer || !path)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if(!writer->file)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, LL_INDEX_FILE_BUFFER);
+    writer->msg_info = msg_info;
+
+    //header is written with zero magic and is rewritten by ll_index_writer_close
+    uint8_t header[LL_INDEX_HEADER_SIZE] = {0};
+    ll_index_write(writer, header, sizeof(header));
+    writer->offset = LL_INDEX_HEADER_SIZE;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_index_writer_add(void* context, ll_status_t status, size_t position, const uint8_t* data)
+{
+    (void)data;
+    ll_index_writer_t* writer = (ll_index_writer_t*)context;
+
+    if(writer->frames % LL_INDEX_BLOCK == 0)
+    {
+        size_t count = (size_t)(writer->frames / LL_INDEX_BLOCK);
+        if(count == writer->checkpoints_capacity)
+        {
+            size_t capacity = count ? count * 2 : 64;
+            uint64_t* checkpoints = realloc(writer->checkpoints, capacity * 2 * sizeof(uint64_t));
+            if(!checkpoints)
+            {
+                writer->failed = true;
+                return;
+            }
+            writer->checkpoints = checkpoints;
+            writer->checkpoints_capacity = capacity;
+        }
+        writer->checkpoints[count * 2] = writer->position;
+        writer->checkpoints[count * 2 + 1] = writer->offset;
+    }
+
+    uint64_t value = ((uint64_t)position - writer->position) << LL_INDEX_STATUS_BITS | (uint64_t)status;
+    uint8_t varint[10];
+    size_t size = 0;
+    do
+    {
+        varint[size] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if(value)
+        {
+            varint[size] |= 0x80;
+        }
+        size++;
+    }
+    while(value);
+
+    ll_index_write(writer, varint, size);
+    writer->offset += size;
+    writer->position = position;
+    writer->frames++;
+}
+
+ll_status_t ll_index_writer_close(ll_index_writer_t* writer, size_t remainder)
+{
+    if(!writer)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint64_t checkpoints_count = (writer->frames + LL_INDEX_BLOCK - 1) / LL_INDEX_BLOCK;
+    for(uint64_t i = 0; i < checkpoints_count * 2 && !writer->failed; i++)
+    {
+        uint8_t value[8];
+        ll_index_put64(value, writer->checkpoints[i]);
+        ll_index_write(writer, value, sizeof(value));
+    }
+
+    uint8_t header[LL_INDEX_HEADER_SIZE] = {0};
+    memcpy(header, LL_INDEX_MAGIC, 8);
+    ll_index_put64(header + 8, writer->msg_info.size);
+    header[16] = writer->msg_info.begin_byte;
+    header[17] = writer->msg_info.reject_byte;
+    header[18] = writer->msg_info.end_byte;
+    header[19] = (uint8_t)writer->msg_info.framing;
+    header[20] = (uint8_t)writer->msg_info.checksum;
+    ll_index_put64(header + 24, writer->frames);
+    ll_index_put64(header + 32, remainder);
+    ll_index_put64(header + 40, writer->offset);
+    ll_index_put64(header + 48, checkpoints_count);
+    if(!writer->failed && fseek(writer->file, 0, SEEK_SET) != 0)
+    {
+        writer->failed = true;
+    }
+    ll_index_write(writer, header, sizeof(header));
+
+    if(fclose(writer->file) != 0)
+    {
+        writer->failed = true;
+    }
+    free(writer->checkpoints);
+    writer->file = NULL;
+    writer->checkpoints = NULL;
+    return writer->failed ? LL_STATUS_BAD_PARAMS : LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_index_build(ll_message_info_t msg_info,
+                           const uint8_t* byte_stream,
+                           size_t byte_stream_size,
+                           size_t threads,
+                           const char* path)
+{
+    if(!byte_stream)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_index_writer_t writer;
+    if(ll_index_writer_open(&writer, msg_info, path) != LL_STATUS_SUCCESS)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    size_t remainder = 0;
+    ll_status_t status = ll_deserialize_parallel(msg_info,
+                                                 byte_stream,
+                                                 byte_stream_size,
+                                                 threads,
+                                                 ll_index_writer_add,
+                                                 &writer,
+                                                 &remainder);
+    if(status == LL_STATUS_BAD_PARAMS)
+    {
+        writer.failed = true;
+    }
+    if(ll_index_writer_close(&writer, remainder) != LL_STATUS_SUCCESS)
+    {
+        //index without magic is never opened, but it is removed to not leave garbage
+        remove(path);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_index_open(ll_index_t* index, const char* path)
+{
+    if(!index || !path)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < LL_INDEX_HEADER_SIZE)
+    {
+        close(fd);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    const uint8_t* header = (const uint8_t*)mapping;
+    index->mapping = header;
+    index->mapping_size = size;
+    index->msg_info.size = ll_index_get64(header + 8);
+    index->msg_info.begin_byte = header[16];
+    index->msg_info.reject_byte = header[17];
+    index->msg_info.end_byte = header[18];
+    index->msg_info.framing = (ll_framing_t)header[19];
+    index->msg_info.checksum = (ll_checksum_t)header[20];
+    index->frames = ll_index_get64(header + 24);
+    index->remainder = ll_index_get64(header + 32);
+    index->checkpoints_offset = ll_index_get64(header + 40);
+    index->checkpoints_count = ll_index_get64(header + 48);
+    index->checkpoints = header + index->checkpoints_offset;
+
+    if(memcmp(header, LL_INDEX_MAGIC, 8) != 0
+       || index->checkpoints_offset < LL_INDEX_HEADER_SIZE
+       || index->checkpoints_offset > size
+       || index->checkpoints_count != (index->frames + LL_INDEX_BLOCK - 1) / LL_INDEX_BLOCK
+       || index->checkpoints_count > (size - index->checkpoints_offset) / 16)
+    {
+        munmap(mapping, size);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_index_close(ll_index_t* index)
+{
+    if(!index || !index->mapping)
+    {
+        return;
+    }
+    munmap((void*)index->mapping, index->mapping_size);
+    index->mapping = NULL;
+}
+
+ll_status_t ll_index_find(const ll_index_t* index, uint64_t frame, uint64_t* position, uint64_t* size)
+{
+    if(!index || !position || !size || frame >= index->frames)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    const uint8_t* checkpoint = index->checkpoints + frame / LL_INDEX_BLOCK * 16;
+    uint64_t current = ll_index_get64(checkpoint);
+    uint64_t offset = ll_index_get64(checkpoint + 8);
+    if(offset < LL_INDEX_HEADER_SIZE || offset >= index->checkpoints_offset)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    const uint8_t* in = index->mapping + offset;
+    const uint8_t* end = index->mapping + index->checkpoints_offset;
+    uint64_t value = 0;
+    for(uint64_t i = frame - frame % LL_INDEX_BLOCK; i <= frame; i++)
+    {
+        if(!ll_index_varint(&in, end, &value))
+        {
+            return LL_STATUS_BAD_PARAMS;
+        }
+        if(i < frame)
+        {
+            current += value >> LL_INDEX_STATUS_BITS;
+        }
+    }
+
+    ll_status_t status = (ll_status_t)(value & ((1u << LL_INDEX_STATUS_BITS) - 1));
+    if(status >= LL_STATUS_ENUM_SIZE)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    *position = current;
+    *size = value >> LL_INDEX_STATUS_BITS;
+    return status;
+}
+
+ll_status_t ll_index_read(const ll_index_t* index, int fd, uint64_t frame, uint8_t* data_out)
+{
+    if(!data_out)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint64_t position;
+    uint64_t size;
+    ll_status_t status = ll_index_find(index, frame, &position, &size);
+    if(status != LL_STATUS_SUCCESS && status != LL_STATUS_CHECKSUM_FAILURE)
+    {
+        return status;
+    }
+    if(size > SIZE_MAX || position > (uint64_t)INT64_MAX)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    //frame is read with bytes which were skipped before it, they are skipped again
+    uint8_t stack[LL_INDEX_STACK_FRAME];
+    uint8_t* buffer = size <= sizeof(stack) ? stack : malloc((size_t)size);
+    if(!buffer)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    size_t done = 0;
+    while(done < size)
+    {
+        ssize_t result = pread(fd, buffer + done, (size_t)size - done, (off_t)(position + done));
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result <= 0)
+        {
+            break;
+        }
+        done += (size_t)result;
+    }
+
+    size_t remainder = 0;
+    status = done == size
+        ? ll_deserialize(index->msg_info, buffer, (size_t)size, data_out, &remainder)
+        : LL_STATUS_BAD_PARAMS;
+    if(buffer != stack)
+    {
+        free(buffer);
+    }
+    return status;
+}
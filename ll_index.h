@@ -0,0 +1,167 @@
+/*
+    Index of frames in big byte stream (for example link capture) for random access.
+
+    Index is a file which is built by one pass over byte stream (ll_index_build uses
+ll_deserialize_parallel) and contains position and status of every result of
+ll_deserialize_all. After that any frame can be parsed by reading only its bytes
+from byte stream, without parsing everything before it.
+
+    Frame N starts at position where parsing of frame N-1 has ended, so only sizes
+of frames are stored: every frame is one LEB128 varint (size << 3 | status), which is
+1-2 bytes for usual messages. Every LL_INDEX_BLOCK frames there is a checkpoint with
+position of frame in byte stream and offset of its varint in index file, so finding
+a frame decodes at most LL_INDEX_BLOCK varints.
+
+    Index file (all numbers are little endian):
+    - header (64 bytes): "LLINDEX1", message info (size: 8 bytes, begin, reject and end
+      bytes, framing, checksum: 1 byte each, 3 bytes padding), quantity of frames,
+      remainder (position of uncompleted message at the end of byte stream), offset and
+      quantity of checkpoints (8 bytes each), 8 bytes padding;
+    - varints of all frames;
+    - checkpoints: position of frame and offset of its varint (8 bytes each).
+    Magic is written last, so index which wasn't closed is never opened.
+
+Example:
+    ll_index_build(msg_info, capture, capture_size, 0, "capture.idx");
+
+    ll_index_t index;
+    if(ll_index_open(&index, "capture.idx") == LL_STATUS_SUCCESS)
+    {
+        status = ll_index_read(&index, capture_fd, 123456789, data);
+        ll_index_close(&index);
+    }
+*/
+
+#ifndef LL_INDEX_H
+#define LL_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+#include <stdio.h>
+
+
+//quantity of frames between checkpoints
+#define LL_INDEX_BLOCK 1024
+
+typedef struct
+{
+    FILE*             file;
+    ll_message_info_t msg_info;
+    uint64_t          frames;
+    uint64_t          position;    //position where parsing of next frame starts
+    uint64_t          offset;      //offset of next varint in index file
+    uint64_t*         checkpoints; //pairs of position and offset
+    size_t            checkpoints_capacity;
+    bool              failed;      //writing or allocation has failed
+} ll_index_writer_t;
+
+typedef struct
+{
+    const uint8_t*    mapping;
+    size_t            mapping_size;
+    ll_message_info_t msg_info;
+    uint64_t          frames;
+    uint64_t          remainder;
+    const uint8_t*    checkpoints;
+    uint64_t          checkpoints_count;
+    uint64_t          checkpoints_offset;
+} ll_index_t;
+
+
+/**
+ * @brief This function creates index file and prepares writer for ll_index_writer_add.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info which is saved to index
+ * @param path path of index file, it is truncated if it exists,
+ * if path == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if file can't be created)
+ */
+ll_status_t ll_index_writer_open(ll_index_writer_t* writer, ll_message_info_t msg_info, const char* path);
+
+/**
+ * @brief This function adds one frame to index. It has type ll_frame_callback_t, so
+ * writer can be passed as context to ll_deserialize_all or ll_deserialize_parallel.
+ * @param context writer
+ * @param status status of frame
+ * @param position position in byte stream where parsing of next frame starts
+ * @param data not used
+ */
+void ll_index_writer_add(void* context, ll_status_t status, size_t position, const uint8_t* data);
+
+/**
+ * @brief This function writes checkpoints and header and closes index file.
+ * @param writer writer,
+ * if writer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param remainder position of uncompleted message at the end of byte stream
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if any write has failed
+ */
+ll_status_t ll_index_writer_close(ll_index_writer_t* writer, size_t remainder);
+
+/**
+ * @brief This function parses whole byte stream with ll_deserialize_parallel and writes
+ * index file.
+ * @param msg_info message info
+ * @param byte_stream the same as in ll_deserialize_parallel
+ * @param byte_stream_size byte stream size
+ * @param threads quantity of threads, 0 means quantity of online CPUs
+ * @param path path of index file
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if parameters are bad or
+ * index can't be written
+ */
+ll_status_t ll_index_build(
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    size_t threads,
+    const char* path
+);
+
+/**
+ * @brief This function maps index file to memory.
+ * @param index index,
+ * if index == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param path path of index file
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS if file can't be mapped or it is
+ * not valid index
+ */
+ll_status_t ll_index_open(ll_index_t* index, const char* path);
+
+/**
+ * @brief This function unmaps index file.
+ * @param index index,
+ * if index == NULL then function does nothing
+ */
+void ll_index_close(ll_index_t* index);
+
+/**
+ * @brief This function finds frame in index.
+ * @param index index
+ * @param frame number of frame from 0
+ * @param position position in byte stream where parsing of frame starts will be putted here
+ * @param size quantity of bytes from "position" to the end of frame will be putted here
+ * @returns status of frame, LL_STATUS_BAD_PARAMS if frame >= index->frames or index is corrupted
+ */
+ll_status_t ll_index_find(const ll_index_t* index, uint64_t frame, uint64_t* position, uint64_t* size);
+
+/**
+ * @brief This function reads frame from byte stream file with pread() and parses it.
+ * Frames without data (LL_STATUS_MESSAGE_TOO_SHORT, LL_STATUS_MESSAGE_TOO_LONG) are not read.
+ * @param index index
+ * @param fd file descriptor of byte stream which was indexed
+ * @param frame number of frame from 0
+ * @param data_out area of memory with size of msg_info.size where message will be putted
+ * @returns status of ll_deserialize for read frame, status of frame if it has no data,
+ * LL_STATUS_BAD_PARAMS if frame is not found or can't be read
+ */
+ll_status_t ll_index_read(const ll_index_t* index, int fd, uint64_t frame, uint8_t* data_out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_INDEX_H
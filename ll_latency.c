@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_latency.h"
+
+#include <time.h>
+
+#if defined(LL_LATENCY_RDTSC) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define LL_LATENCY_USE_RDTSC
+#endif
+
+#define LL_LATENCY_SUB_COUNT ((uint64_t)1 << LL_LATENCY_SUB_BITS)
+
+
+static uint64_t ll_latency_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static size_t ll_latency_bucket(uint64_t ticks)
+{
+    if(ticks < LL_LATENCY_SUB_COUNT)
+    {
+        return (size_t)ticks;
+    }
+    if(ticks >> LL_LATENCY_MAX_BITS)
+    {
+        return LL_LATENCY_BUCKETS - 1;
+    }
+    unsigned exponent = 63 - (unsigned)__builtin_clzll(ticks);
+    uint64_t mantissa = ticks >> (exponent - LL_LATENCY_SUB_BITS);
+    return (size_t)((exponent - LL_LATENCY_SUB_BITS + 1) * LL_LATENCY_SUB_COUNT
+                    + (mantissa - LL_LATENCY_SUB_COUNT));
+}
+
+//the highest value which is recorded to bucket
+static uint64_t ll_latency_bucket_max(size_t bucket)
+{
+    if(bucket < LL_LATENCY_SUB_COUNT)
+    {
+        return bucket;
+    }
+    unsigned exponent = (unsigned)(bucket / LL_LATENCY_SUB_COUNT) + LL_LATENCY_SUB_BITS - 1;
+    uint64_t mantissa = bucket % LL_LATENCY_SUB_COUNT + LL_LATENCY_SUB_COUNT;
+    return ((mantissa + 1) << (exponent - LL_LATENCY_SUB_BITS)) - 1;
+}
+
+uint64_t ll_latency_now(void)
+{
+#ifdef LL_LATENCY_USE_RDTSC
+    return __rdtsc();
+#else
+    return ll_latency_clock_ns();
+#endif
+}
+
+void ll_latency_histogram_init(ll_latency_histogram_t* histogram)
+{
+    if(!histogram)
+    {
+        return;
+    }
+    for(size_t i = 0; i < LL_LATENCY_BUCKETS; i++)
+    {
+        atomic_init(&histogram->buckets[i], 0);
+    }
+    atomic_init(&histogram->max, 0);
+    atomic_init(&histogram->sum, 0);
+
+#ifdef LL_LATENCY_USE_RDTSC
+    uint64_t ns_begin = ll_latency_clock_ns();
+    uint64_t ticks_begin = __rdtsc();
+    uint64_t ns_end;
+    do
+    {
+        ns_end = ll_latency_clock_ns();
+    }
+    while(ns_end - ns_begin < 10000000u);
+    histogram->ticks_per_second = (double)(__rdtsc() - ticks_begin) * 1e9 / (double)(ns_end - ns_begin);
+#else
+    histogram->ticks_per_second = 1e9;
+#endif
+}
+
+void ll_latency_record(ll_latency_histogram_t* histogram, uint64_t ticks)
+{
+    if(!histogram)
+    {
+        return;
+    }
+
+    //there is only one writer, so relaxed load and store are enough and
+    //no locked instructions are needed
+    LL_ATOMIC(uint64_t)* bucket = &histogram->buckets[ll_latency_bucket(ticks)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&histogram->sum,
+                          atomic_load_explicit(&histogram->sum, memory_order_relaxed) + ticks,
+                          memory_order_relaxed);
+    if(ticks > atomic_load_explicit(&histogram->max, memory_order_relaxed))
+    {
+        atomic_store_explicit(&histogram->max, ticks, memory_order_relaxed);
+    }
+}
+
+void ll_latency_snapshot(const ll_latency_histogram_t* histogram, ll_latency_snapshot_t* snapshot)
+{
+    if(!histogram || !snapshot)
+    {
+        return;
+    }
+
+    //buckets are read one by one while writer works, so count is calculated
+    //from copied buckets to be consistent with them
+    snapshot->count = 0;
+    for(size_t i = 0; i < LL_LATENCY_BUCKETS; i++)
+    {
+        snapshot->buckets[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        snapshot->count += snapshot->buckets[i];
+    }
+    snapshot->max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    snapshot->sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+    snapshot->ticks_per_second = histogram->ticks_per_second;
+}
+
+uint64_t ll_latency_percentile(const ll_latency_snapshot_t* snapshot, double percentile)
+{
+    if(!snapshot || snapshot->count == 0)
+    {
+        return 0;
+    }
+
+    double rank = percentile / 100.0 * (double)snapshot->count;
+    uint64_t wanted = rank < 1.0 ? 1 : (uint64_t)rank;
+    if((double)wanted < rank)
+    {
+        wanted++;
+    }
+
+    uint64_t seen = 0;
+    size_t bucket = 0;
+    for(; bucket < LL_LATENCY_BUCKETS - 1; bucket++)
+    {
+        seen += snapshot->buckets[bucket];
+        if(seen >= wanted)
+        {
+            break;
+        }
+    }
+
+    uint64_t ticks = ll_latency_bucket_max(bucket);
+    if(ticks > snapshot->max)
+    {
+        ticks = snapshot->max;
+    }
+    return (uint64_t)((double)ticks * 1e9 / snapshot->ticks_per_second);
+}
+
+void ll_latency_tracker_init(ll_latency_tracker_t* tracker, ll_latency_histogram_t* histogram)
+{
+    if(!tracker)
+    {
+        return;
+    }
+    tracker->histogram = histogram;
+    tracker->begin = 0;
+    tracker->pending = false;
+}
+
+void ll_latency_begin(ll_latency_tracker_t* tracker)
+{
+    if(tracker && !tracker->pending)
+    {
+        tracker->begin = ll_latency_now();
+        tracker->pending = true;
+    }
+}
+
+void ll_latency_end(ll_latency_tracker_t* tracker, bool delivered)
+{
+    if(!tracker || !tracker->pending)
+    {
+        return;
+    }
+    if(delivered)
+    {
+        ll_latency_record(tracker->histogram, ll_latency_now() - tracker->begin);
+    }
+    tracker->pending = false;
+}
+
+ll_status_t ll_deserialize_traced(ll_latency_tracker_t* tracker,
+                                  ll_message_info_t msg_info,
+                                  const uint8_t* byte_stream,
+                                  size_t byte_stream_size,
+                                  uint8_t* data_out,
+                                  size_t* remainder)
+{
+    if(!tracker)
+    {
+        return ll_deserialize(msg_info, byte_stream, byte_stream_size, data_out, remainder);
+    }
+
+    //timestamp is taken before parsing, it is used only if message is found
+    uint64_t call_begin = ll_latency_now();
+    ll_status_t status = ll_deserialize(msg_info, byte_stream, byte_stream_size, data_out, remainder);
+
+    switch(status)
+    {
+    case LL_STATUS_NO_ENOUGH_BYTES:
+        if(!tracker->pending)
+        {
+            tracker->begin = call_begin;
+            tracker->pending = true;
+        }
+        break;
+    case LL_STATUS_SUCCESS:
+        if(!tracker->pending)
+        {
+            tracker->begin = call_begin;
+            tracker->pending = true;
+        }
+        ll_latency_end(tracker, true);
+        break;
+    case LL_STATUS_NO_MESSAGE:
+    case LL_STATUS_BAD_PARAMS:
+        break;
+    default:
+        ll_latency_end(tracker, false);
+        break;
+    }
+    return status;
+}
@@ -0,0 +1,164 @@
+/*
+    Instrumentation of message latency: time from the moment when "begin byte"
+of message was detected by deserializer to the moment when message was parsed.
+Decoder (see ll_decoder_t) and readers built on it (ll_uring.h, ll_epoll.h) take
+both timestamps themselves when tracker is given to them.
+
+    Latencies are recorded to histogram with logarithmic buckets (like HDR histogram):
+every power of two is split into 32 linear buckets, so relative error of any
+percentile is less than 1/32 and recording is one increment. Histogram has one
+writer (thread which parses messages) and any thread can take snapshot of it
+at any time without stopping the writer.
+
+    Timestamps are taken with clock_gettime(CLOCK_MONOTONIC) in nanoseconds. If
+LL_LATENCY_RDTSC is defined on x86, rdtsc is used instead, which is several times
+cheaper, and ticks are converted to nanoseconds in snapshot.
+
+Example:
+    ll_latency_histogram_t histogram;
+    ll_latency_tracker_t tracker;
+    ll_latency_histogram_init(&histogram);
+    ll_latency_tracker_init(&tracker, &histogram);
+
+    //receiving thread
+    status = ll_deserialize_traced(&tracker, msg_info, buffer, size, data, &remainder);
+
+    //or receiving thread with decoder
+    ll_decoder_init(&decoder, msg_info, data);
+    decoder.tracker = &tracker;
+    parsed = ll_decoder_push(&decoder, buffer, size, &consumed);
+
+    //monitoring thread
+    ll_latency_snapshot_t snapshot;
+    ll_latency_snapshot(&histogram, &snapshot);
+    p99 = ll_latency_percentile(&snapshot, 99.0);
+*/
+
+#ifndef LL_LATENCY_H
+#define LL_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_atomic.h"
+
+
+//every power of two is split into 2^LL_LATENCY_SUB_BITS buckets
+#define LL_LATENCY_SUB_BITS 5
+//values bigger than 2^LL_LATENCY_MAX_BITS ticks are recorded to the last bucket
+#define LL_LATENCY_MAX_BITS 40
+#define LL_LATENCY_BUCKETS ((LL_LATENCY_MAX_BITS - LL_LATENCY_SUB_BITS + 2) << LL_LATENCY_SUB_BITS)
+
+typedef struct
+{
+    LL_ATOMIC(uint64_t) buckets[LL_LATENCY_BUCKETS];
+    LL_ATOMIC(uint64_t) max;
+    LL_ATOMIC(uint64_t) sum;
+    double ticks_per_second;
+} ll_latency_histogram_t;
+
+typedef struct
+{
+    uint64_t buckets[LL_LATENCY_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+    uint64_t sum;
+    double ticks_per_second;
+} ll_latency_snapshot_t;
+
+//it is declared in ll_protocol.h as tracker of ll_decoder_t
+typedef struct ll_latency_tracker_s
+{
+    ll_latency_histogram_t* histogram;
+    uint64_t begin;   //timestamp of detected "begin byte"
+    bool     pending; //"begin byte" was detected and message is not parsed yet
+} ll_latency_tracker_t;
+
+
+/**
+ * @brief This function returns current timestamp in ticks (nanoseconds or rdtsc ticks).
+ */
+uint64_t ll_latency_now(void);
+
+/**
+ * @brief This function initializes empty histogram. With LL_LATENCY_RDTSC it also
+ * measures rdtsc frequency, which takes about 10 milliseconds.
+ * @param histogram histogram,
+ * if histogram == NULL then function does nothing
+ */
+void ll_latency_histogram_init(ll_latency_histogram_t* histogram);
+
+/**
+ * @brief This function records one latency. It must be called only from one thread.
+ * @param histogram histogram,
+ * if histogram == NULL then function does nothing
+ * @param ticks latency in ticks
+ */
+void ll_latency_record(ll_latency_histogram_t* histogram, uint64_t ticks);
+
+/**
+ * @brief This function copies histogram. It can be called from any thread.
+ * @param histogram histogram,
+ * if histogram == NULL then function does nothing
+ * @param snapshot area of memory where copy will be putted,
+ * if snapshot == NULL then function does nothing
+ */
+void ll_latency_snapshot(const ll_latency_histogram_t* histogram, ll_latency_snapshot_t* snapshot);
+
+/**
+ * @brief This function calculates percentile of recorded latencies.
+ * @param snapshot snapshot of histogram
+ * @param percentile percentile from 0 to 100 (for example 99.9 for p999)
+ * @returns latency in nanoseconds (the highest value of bucket where percentile is),
+ * 0 if snapshot == NULL or there are no recorded latencies
+ */
+uint64_t ll_latency_percentile(const ll_latency_snapshot_t* snapshot, double percentile);
+
+/**
+ * @brief This function initializes tracker which records latencies of one byte stream.
+ * @param tracker tracker
+ * @param histogram histogram where latencies will be recorded
+ */
+void ll_latency_tracker_init(ll_latency_tracker_t* tracker, ll_latency_histogram_t* histogram);
+
+/**
+ * @brief This function must be called when "begin byte" of message is detected.
+ * If it is already detected (message is received by parts) function does nothing.
+ * @param tracker tracker
+ */
+void ll_latency_begin(ll_latency_tracker_t* tracker);
+
+/**
+ * @brief This function must be called when message is parsed or lost.
+ * @param tracker tracker
+ * @param delivered true if message was parsed (latency is recorded), false if it
+ * was lost (latency is not recorded)
+ */
+void ll_latency_end(ll_latency_tracker_t* tracker, bool delivered);
+
+/**
+ * @brief This function does the same as ll_deserialize and records latency of parsed
+ * message. ll_deserialize doesn't report where "begin byte" was detected, so it is
+ * considered detected at the start of the first call which returns
+ * LL_STATUS_NO_ENOUGH_BYTES for the message, or at the start of this call if whole
+ * message is in "byte_stream". For exact timestamps use decoder with tracker
+ * (see ll_decoder_init), it stamps the moment when "begin byte" is parsed.
+ * @param tracker tracker, if tracker == NULL function only calls ll_deserialize
+ * @returns the same as ll_deserialize
+ */
+ll_status_t ll_deserialize_traced(
+    ll_latency_tracker_t* tracker,
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    uint8_t* data_out,
+    size_t* remainder
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_LATENCY_H
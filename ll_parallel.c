@@ -0,0 +1,879 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_parallel.h"
+#include "ll_crc32c.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+//size of byte stream part which is parsed by one thread in one round
+#ifndef LL_PARALLEL_CHUNK
+#define LL_PARALLEL_CHUNK ((size_t)1024 * 1024)
+#endif
+
+//maximal initial quantity of results and messages reserved by thread, it is smaller
+//for big messages (as many messages as chunk can hold), arrays grow when it is needed
+#define LL_PARALLEL_RESERVE 256
+
+//chunk is made bigger for big messages, so it holds at least this quantity of frames
+//and most of messages don't cross chunk boundaries
+#define LL_PARALLEL_CHUNK_FRAMES 4
+
+//maximal quantity of messages in the second (alternative) chain of chunk
+#define LL_PARALLEL_ALTERNATIVE_MAX 64
+
+//minimal part of message which is serialized by one thread
+#ifndef LL_PARALLEL_PART_MIN
+#define LL_PARALLEL_PART_MIN ((size_t)64 * 1024)
+#endif
+
+//part of message is counted by steps of this size, so checksum is calculated
+//while step is still in cache
+#define LL_PARALLEL_STEP ((size_t)16 * 1024)
+
+
+typedef struct
+{
+    size_t      start;       //position where parsing was started
+    size_t      open;        //position where message was opened (see ll_open_position)
+    size_t      next;        //position where parsing of next message starts
+    size_t      data_offset; //offset of parsed message in "data" of worker
+    ll_status_t status;
+} ll_parallel_result_t;
+
+//part of message which is serialized by one thread
+typedef struct
+{
+    ll_message_info_t msg_info;
+    const uint8_t*    data_in;
+    size_t            size;
+    uint8_t*          data_out;
+    size_t            escaped_size;
+    uint32_t          checksum;
+    pthread_t         thread;
+    bool              started;
+} ll_parallel_part_t;
+
+typedef struct ll_parallel_s ll_parallel_t;
+
+typedef struct
+{
+    ll_parallel_t*        parallel;
+    pthread_t             thread;
+    size_t                chunk_begin;
+    size_t                chunk_end;
+    bool                  exact_begin; //"chunk_begin" is position of sequential parsing
+    ll_parallel_result_t* results;
+    size_t                results_count;
+    size_t                results_capacity;
+    uint8_t*              data;
+    size_t                data_size;
+    size_t                data_capacity;
+} ll_parallel_worker_t;
+
+struct ll_parallel_s
+{
+    ll_message_info_t     msg_info;
+    const uint8_t*        byte_stream;
+    size_t                byte_stream_size;
+    size_t                chunk;
+    ll_parallel_worker_t* workers;
+    size_t                workers_count;
+    pthread_mutex_t       start_lock;
+    pthread_barrier_t     round_begin;
+    pthread_barrier_t     round_end;
+    bool                  stop;
+};
+
+
+static bool ll_has_data(ll_status_t status)
+{
+    return status == LL_STATUS_SUCCESS || status == LL_STATUS_CHECKSUM_FAILURE;
+}
+
+//returns position where parsing of next message starts after parsing at "position"
+//has returned "status" and "remainder" relative to "position"
+static size_t ll_next_position(ll_status_t status, size_t remainder, size_t position, size_t byte_stream_size)
+{
+    switch(status)
+    {
+    case LL_STATUS_NO_MESSAGE:
+    case LL_STATUS_BAD_PARAMS:
+        return byte_stream_size;
+    case LL_STATUS_NO_ENOUGH_BYTES:
+        return position + remainder;
+    default:
+        //remainder is 0 when message ends at the end of byte stream
+        if(ll_has_data(status) && remainder == 0)
+        {
+            return byte_stream_size;
+        }
+        //parsing must move forward even for broken messages with size 0
+        return remainder == 0 ? position + 1 : position + remainder;
+    }
+}
+
+//parses one message starting at "position", returns position where parsing of next message starts,
+//if "frame" is not NULL message is only scanned and "frame" is filled with absolute position
+static size_t ll_parse_step(ll_message_info_t msg_info,
+                            const uint8_t* byte_stream,
+                            size_t byte_stream_size,
+                            size_t position,
+                            uint8_t* data_out,
+                            ll_frame_scan_t* frame,
+                            ll_status_t* status)
+{
+    size_t remainder = 0;
+    if(frame)
+    {
+        *status = ll_scan(msg_info,
+                          byte_stream + position,
+                          byte_stream_size - position,
+                          frame,
+                          &remainder);
+        frame->begin += position;
+    }
+    else
+    {
+        *status = ll_deserialize(msg_info,
+                                 byte_stream + position,
+                                 byte_stream_size - position,
+                                 data_out,
+                                 &remainder);
+    }
+    return ll_next_position(*status, remainder, position, byte_stream_size);
+}
+
+//returns the first position in chunk where message can start
+static size_t ll_first_candidate(ll_message_info_t msg_info,
+                                 const uint8_t* byte_stream,
+                                 size_t chunk_begin,
+                                 size_t chunk_end)
+{
+    size_t i = chunk_begin;
+    if(i == 0)
+    {
+        return 0;
+    }
+
+    while(i < chunk_end)
+    {
+        uint8_t wanted = msg_info.framing == LL_FRAMING_COBS ? msg_info.end_byte : msg_info.begin_byte;
+        const uint8_t* found = memchr(byte_stream + i, wanted, chunk_end - i);
+        if(!found)
+        {
+            return chunk_end;
+        }
+        i = (size_t)(found - byte_stream);
+
+        switch(msg_info.framing)
+        {
+        case LL_FRAMING_COBS:
+            //message can start only after "end byte" of previous one
+            return i + 1;
+        case LL_FRAMING_XOR:
+            return i;
+        default:
+            if(byte_stream[i - 1] != msg_info.reject_byte)
+            {
+                return i;
+            }
+            break;
+        }
+        i++;
+    }
+    return chunk_end;
+}
+
+//returns position where ll_deserialize called at "position" opens message (the first
+//"begin byte", in LL_FRAMING_REJECT mode not after "reject byte" unless it is the first
+//byte) or "end" if there is no such position. Calls which open message at the same
+//position give the same results, only skipped bytes before it are different
+static size_t ll_open_position(ll_message_info_t msg_info,
+                               const uint8_t* byte_stream,
+                               size_t position,
+                               size_t end)
+{
+    size_t i = position;
+    while(i < end)
+    {
+        const uint8_t* found = memchr(byte_stream + i, msg_info.begin_byte, end - i);
+        if(!found)
+        {
+            return end;
+        }
+        i = (size_t)(found - byte_stream);
+        if(   msg_info.framing != LL_FRAMING_REJECT
+           || i == position
+           || byte_stream[i - 1] != msg_info.reject_byte)
+        {
+            return i;
+        }
+        i++;
+    }
+    return end;
+}
+
+static bool ll_worker_reserve(ll_parallel_worker_t* worker)
+{
+    if(worker->results_count == worker->results_capacity)
+    {
+        size_t capacity = worker->results_capacity * 2;
+        ll_parallel_result_t* results = realloc(worker->results, capacity * sizeof(*results));
+        if(!results)
+        {
+            return false;
+        }
+        worker->results = results;
+        worker->results_capacity = capacity;
+    }
+    if(worker->data_size + worker->parallel->msg_info.size > worker->data_capacity)
+    {
+        size_t capacity = worker->data_capacity * 2;
+        uint8_t* data = realloc(worker->data, capacity);
+        if(!data)
+        {
+            return false;
+        }
+        worker->data = data;
+        worker->data_capacity = capacity;
+    }
+    return true;
+}
+
+//returns index of the first result which starts at "position" or after it
+static size_t ll_worker_find(const ll_parallel_worker_t* worker, size_t count, size_t position)
+{
+    size_t low = 0;
+    size_t high = count;
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if(worker->results[middle].start < position)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+//parses chain of messages from "position", every next message starts where previous one ended.
+//Chain stops at the end of chunk, after "max" messages or when it reaches start of one of
+//the first "known" results (they are the same from that position)
+static void ll_worker_parse_chain(ll_parallel_worker_t* worker, size_t position, size_t known, size_t max)
+{
+    const ll_parallel_t* parallel = worker->parallel;
+    size_t first = worker->results_count;
+
+    //if memory can't be reserved the rest of chunk is parsed during merge
+    while(   position < worker->chunk_end
+          && worker->results_count - first < max
+          && ll_worker_reserve(worker))
+    {
+        if(known)
+        {
+            size_t k = ll_worker_find(worker, known, position);
+            if(k < known && worker->results[k].start == position)
+            {
+                break;
+            }
+        }
+        ll_parallel_result_t* result = &worker->results[worker->results_count++];
+        result->start = position;
+        result->open = ll_open_position(parallel->msg_info,
+                                        parallel->byte_stream,
+                                        position,
+                                        parallel->byte_stream_size);
+        result->data_offset = worker->data_size;
+        result->next = ll_parse_step(parallel->msg_info,
+                                     parallel->byte_stream,
+                                     parallel->byte_stream_size,
+                                     position,
+                                     worker->data + worker->data_size,
+                                     NULL,
+                                     &result->status);
+        if(ll_has_data(result->status))
+        {
+            worker->data_size += parallel->msg_info.size;
+        }
+        if(   result->status == LL_STATUS_NO_MESSAGE
+           || result->status == LL_STATUS_NO_ENOUGH_BYTES)
+        {
+            break;
+        }
+        position = result->next;
+    }
+}
+
+//returns position of the first "begin byte" after "reject byte" from "begin" to "end"
+//or "end" if there is no such position
+static size_t ll_rejected_candidate(ll_message_info_t msg_info,
+                                    const uint8_t* byte_stream,
+                                    size_t begin,
+                                    size_t end)
+{
+    for(size_t i = begin > 0 ? begin : 1; i < end; i++)
+    {
+        const uint8_t* found = memchr(byte_stream + i, msg_info.begin_byte, end - i);
+        if(!found)
+        {
+            return end;
+        }
+        i = (size_t)(found - byte_stream);
+        if(byte_stream[i - 1] == msg_info.reject_byte)
+        {
+            return i;
+        }
+    }
+    return end;
+}
+
+//inserts results from "first" to the end of array into sorted results before "first"
+static void ll_worker_sort(ll_parallel_worker_t* worker, size_t first)
+{
+    for(size_t i = first; i < worker->results_count; i++)
+    {
+        ll_parallel_result_t result = worker->results[i];
+        size_t k = ll_worker_find(worker, i, result.start);
+        memmove(&worker->results[k + 1], &worker->results[k], (i - k) * sizeof(result));
+        worker->results[k] = result;
+    }
+}
+
+static void ll_worker_parse_chunk(ll_parallel_worker_t* worker)
+{
+    const ll_parallel_t* parallel = worker->parallel;
+    ll_message_info_t msg_info = parallel->msg_info;
+    size_t position = worker->exact_begin
+                      ? worker->chunk_begin
+                      : ll_first_candidate(msg_info,
+                                           parallel->byte_stream,
+                                           worker->chunk_begin,
+                                           worker->chunk_end);
+
+    worker->results_count = 0;
+    worker->data_size = 0;
+    ll_worker_parse_chain(worker, position, 0, SIZE_MAX);
+
+    //in LL_FRAMING_REJECT mode escape state at the beginning of chunk is not known: "begin byte"
+    //after "reject byte" is skipped by ll_first_candidate, but sequential parsing opens message
+    //there if it starts exactly at that position (for example after too long message). Both
+    //states are tracked: the second chain starts at that "begin byte" and is parsed till it
+    //reaches the first chain
+    if(msg_info.framing == LL_FRAMING_REJECT && !worker->exact_begin)
+    {
+        size_t candidate = ll_rejected_candidate(msg_info, parallel->byte_stream, worker->chunk_begin, position);
+        size_t known = worker->results_count;
+        if(candidate < position)
+        {
+            ll_worker_parse_chain(worker, candidate, known, LL_PARALLEL_ALTERNATIVE_MAX);
+            ll_worker_sort(worker, known);
+        }
+    }
+}
+
+static void* ll_worker_thread(void* arg)
+{
+    ll_parallel_worker_t* worker = arg;
+    ll_parallel_t* parallel = worker->parallel;
+
+    pthread_mutex_lock(&parallel->start_lock);
+    bool stop = parallel->stop;
+    pthread_mutex_unlock(&parallel->start_lock);
+    if(stop)
+    {
+        return NULL;
+    }
+
+    for(;;)
+    {
+        pthread_barrier_wait(&parallel->round_begin);
+        if(parallel->stop)
+        {
+            return NULL;
+        }
+        ll_worker_parse_chunk(worker);
+        pthread_barrier_wait(&parallel->round_end);
+    }
+}
+
+static size_t ll_threads_count(size_t threads)
+{
+    if(threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    return threads;
+}
+
+static void* ll_part_count(void* arg)
+{
+    ll_parallel_part_t* part = arg;
+    part->escaped_size = 0;
+    part->checksum = 0;
+    for(size_t i = 0; i < part->size; i += LL_PARALLEL_STEP)
+    {
+        size_t step = part->size - i < LL_PARALLEL_STEP ? part->size - i : LL_PARALLEL_STEP;
+        part->escaped_size += ll_sizeof_escaped(part->msg_info, part->data_in + i, step);
+        if(part->msg_info.checksum == LL_CHECKSUM_CRC32C)
+        {
+            part->checksum = ll_crc32c(part->checksum, part->data_in + i, step);
+        }
+    }
+    return NULL;
+}
+
+static void* ll_part_escape(void* arg)
+{
+    ll_parallel_part_t* part = arg;
+    ll_escape(part->msg_info, part->data_in, part->size, part->data_out);
+    return NULL;
+}
+
+//the calling thread processes the first part and parts for which thread can't be created
+static void ll_parts_run(ll_parallel_part_t* parts, size_t count, void* (*function)(void*))
+{
+    for(size_t i = 1; i < count; i++)
+    {
+        parts[i].started = pthread_create(&parts[i].thread, NULL, function, &parts[i]) == 0;
+    }
+    function(&parts[0]);
+    for(size_t i = 1; i < count; i++)
+    {
+        if(parts[i].started)
+        {
+            pthread_join(parts[i].thread, NULL);
+        }
+        else
+        {
+            function(&parts[i]);
+        }
+    }
+}
+
+
+ll_status_t ll_deserialize_all(ll_message_info_t msg_info,
+                               const uint8_t* byte_stream,
+                               size_t byte_stream_size,
+                               ll_frame_callback_t callback,
+                               void* context,
+                               size_t* remainder)
+{
+    if(!byte_stream || !callback || !remainder)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint8_t* data = malloc(msg_info.size ? msg_info.size : 1);
+    if(!data)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_status_t result = LL_STATUS_SUCCESS;
+    size_t position = 0;
+    *remainder = byte_stream_size;
+
+    while(position < byte_stream_size)
+    {
+        ll_status_t status;
+        size_t next = ll_parse_step(msg_info, byte_stream, byte_stream_size, position, data, NULL, &status);
+        if(status == LL_STATUS_BAD_PARAMS)
+        {
+            result = status;
+            break;
+        }
+        if(status == LL_STATUS_NO_MESSAGE)
+        {
+            break;
+        }
+        if(status == LL_STATUS_NO_ENOUGH_BYTES)
+        {
+            *remainder = next;
+            result = status;
+            break;
+        }
+        callback(context, status, next, ll_has_data(status) ? data : NULL);
+        position = next;
+    }
+
+    free(data);
+    return result;
+}
+
+ll_status_t ll_deserialize_filtered_all(ll_message_info_t msg_info,
+                                        const ll_filter_t* filter,
+                                        const uint8_t* byte_stream,
+                                        size_t byte_stream_size,
+                                        ll_frame_callback_t callback,
+                                        void* context,
+                                        size_t* remainder)
+{
+    if(!byte_stream || !callback || !remainder)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint8_t* data = malloc(msg_info.size ? msg_info.size : 1);
+    if(!data)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_status_t result = LL_STATUS_SUCCESS;
+    size_t position = 0;
+    *remainder = byte_stream_size;
+
+    while(position < byte_stream_size)
+    {
+        bool matched = false;
+        size_t frame_remainder = 0;
+        ll_status_t status = ll_deserialize_filtered(msg_info,
+                                                     filter,
+                                                     byte_stream + position,
+                                                     byte_stream_size - position,
+                                                     data,
+                                                     &matched,
+                                                     &frame_remainder);
+        size_t next = ll_next_position(status, frame_remainder, position, byte_stream_size);
+        if(status == LL_STATUS_BAD_PARAMS)
+        {
+            result = status;
+            break;
+        }
+        if(status == LL_STATUS_NO_MESSAGE)
+        {
+            break;
+        }
+        if(status == LL_STATUS_NO_ENOUGH_BYTES)
+        {
+            *remainder = next;
+            result = status;
+            break;
+        }
+        callback(context, status, next, ll_has_data(status) && matched ? data : NULL);
+        position = next;
+    }
+
+    free(data);
+    return result;
+}
+
+ll_status_t ll_scan_all(ll_message_info_t msg_info,
+                        const uint8_t* byte_stream,
+                        size_t byte_stream_size,
+                        ll_scan_callback_t callback,
+                        void* context,
+                        size_t* remainder)
+{
+    if(!byte_stream || !callback || !remainder)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_status_t result = LL_STATUS_SUCCESS;
+    size_t position = 0;
+    *remainder = byte_stream_size;
+
+    while(position < byte_stream_size)
+    {
+        ll_status_t status;
+        ll_frame_scan_t frame;
+        size_t next = ll_parse_step(msg_info, byte_stream, byte_stream_size, position, NULL, &frame, &status);
+        if(status == LL_STATUS_BAD_PARAMS)
+        {
+            result = status;
+            break;
+        }
+        if(status == LL_STATUS_NO_MESSAGE)
+        {
+            break;
+        }
+        if(status == LL_STATUS_NO_ENOUGH_BYTES)
+        {
+            *remainder = next;
+            result = status;
+            break;
+        }
+        callback(context, status, next, &frame);
+        position = next;
+    }
+
+    return result;
+}
+
+ll_status_t ll_deserialize_parallel(ll_message_info_t msg_info,
+                                    const uint8_t* byte_stream,
+                                    size_t byte_stream_size,
+                                    size_t threads,
+                                    ll_frame_callback_t callback,
+                                    void* context,
+                                    size_t* remainder)
+{
+    if(!byte_stream || !callback || !remainder)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    //message which doesn't fit into chunk is parsed again during merge, so chunk holds several frames
+    size_t chunk = LL_PARALLEL_CHUNK;
+    size_t frame_max = ll_sizeof_serialized_max(msg_info);
+    if(frame_max > chunk / LL_PARALLEL_CHUNK_FRAMES)
+    {
+        chunk = frame_max * LL_PARALLEL_CHUNK_FRAMES;
+    }
+    threads = ll_threads_count(threads);
+    if(threads > byte_stream_size / chunk)
+    {
+        threads = byte_stream_size / chunk;
+    }
+    if(threads < 2)
+    {
+        return ll_deserialize_all(msg_info, byte_stream, byte_stream_size, callback, context, remainder);
+    }
+
+    ll_parallel_t parallel;
+    parallel.msg_info = msg_info;
+    parallel.byte_stream = byte_stream;
+    parallel.byte_stream_size = byte_stream_size;
+    parallel.chunk = chunk;
+    parallel.workers_count = 0;
+    parallel.stop = false;
+    parallel.workers = calloc(threads, sizeof(ll_parallel_worker_t));
+    uint8_t* data = malloc(msg_info.size ? msg_info.size : 1);
+    if(!parallel.workers || !data || pthread_mutex_init(&parallel.start_lock, NULL) != 0)
+    {
+        free(parallel.workers);
+        free(data);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    size_t workers_allocated = threads;
+
+    //memory for as many messages as chunk of LL_PARALLEL_CHUNK can hold is reserved,
+    //arrays grow when more messages are parsed
+    size_t reserve = LL_PARALLEL_CHUNK / (msg_info.size + 2) + 1;
+    if(reserve > LL_PARALLEL_RESERVE)
+    {
+        reserve = LL_PARALLEL_RESERVE;
+    }
+    bool ok = true;
+    for(size_t i = 0; i < threads && ok; i++)
+    {
+        ll_parallel_worker_t* worker = &parallel.workers[i];
+        worker->parallel = &parallel;
+        worker->results_capacity = reserve;
+        worker->results = malloc(worker->results_capacity * sizeof(ll_parallel_result_t));
+        worker->data_capacity = reserve * (msg_info.size ? msg_info.size : 1);
+        worker->data = malloc(worker->data_capacity);
+        ok = worker->results && worker->data;
+    }
+
+    //threads wait for "start_lock" until barriers are created for quantity of threads
+    //which were really started, the calling thread is worker 0
+    pthread_mutex_lock(&parallel.start_lock);
+    parallel.workers_count = 1;
+    while(ok && parallel.workers_count < threads)
+    {
+        ll_parallel_worker_t* worker = &parallel.workers[parallel.workers_count];
+        if(pthread_create(&worker->thread, NULL, ll_worker_thread, worker) != 0)
+        {
+            break;
+        }
+        parallel.workers_count++;
+    }
+    ok = ok && pthread_barrier_init(&parallel.round_begin, NULL, (unsigned)parallel.workers_count) == 0;
+    if(ok && pthread_barrier_init(&parallel.round_end, NULL, (unsigned)parallel.workers_count) != 0)
+    {
+        pthread_barrier_destroy(&parallel.round_begin);
+        ok = false;
+    }
+    parallel.stop = !ok;
+    pthread_mutex_unlock(&parallel.start_lock);
+    threads = parallel.workers_count;
+
+    ll_status_t result = ok ? LL_STATUS_SUCCESS : LL_STATUS_BAD_PARAMS;
+    size_t position = 0;
+    bool finished = !ok;
+    *remainder = byte_stream_size;
+
+    while(!finished && position < byte_stream_size)
+    {
+        for(size_t i = 0; i < threads; i++)
+        {
+            ll_parallel_worker_t* worker = &parallel.workers[i];
+            size_t begin = position + i * chunk;
+            size_t end = begin + chunk;
+            worker->chunk_begin = begin < byte_stream_size ? begin : byte_stream_size;
+            worker->chunk_end = end < byte_stream_size ? end : byte_stream_size;
+            worker->exact_begin = i == 0;
+        }
+
+        pthread_barrier_wait(&parallel.round_begin);
+        ll_worker_parse_chunk(&parallel.workers[0]);
+        pthread_barrier_wait(&parallel.round_end);
+
+        //merge, results of worker are taken only from the position which was
+        //reached by sequential parsing
+        for(size_t i = 0; i < threads && !finished; i++)
+        {
+            const ll_parallel_worker_t* worker = &parallel.workers[i];
+            size_t j = 0;
+            while(!finished && position < worker->chunk_end)
+            {
+                while(j < worker->results_count && worker->results[j].start < position)
+                {
+                    j++;
+                }
+
+                ll_status_t status;
+                size_t next;
+                const uint8_t* message;
+                size_t taken = worker->results_count;
+                if(j < worker->results_count && worker->results[j].start == position)
+                {
+                    taken = j;
+                }
+                else if(j < worker->results_count)
+                {
+                    //result of parsing which opens message at the same position is the same
+                    size_t open = ll_open_position(msg_info, byte_stream, position, byte_stream_size);
+                    for(size_t k = j; k < worker->results_count && worker->results[k].start <= open; k++)
+                    {
+                        if(worker->results[k].open == open)
+                        {
+                            taken = k;
+                            break;
+                        }
+                    }
+                }
+
+                if(taken < worker->results_count)
+                {
+                    status = worker->results[taken].status;
+                    next = worker->results[taken].next;
+                    message = worker->data + worker->results[taken].data_offset;
+                    j = taken + 1;
+                }
+                else
+                {
+                    next = ll_parse_step(msg_info, byte_stream, byte_stream_size, position, data, NULL, &status);
+                    message = data;
+                }
+
+                if(status == LL_STATUS_BAD_PARAMS)
+                {
+                    result = status;
+                    finished = true;
+                }
+                else if(status == LL_STATUS_NO_MESSAGE)
+                {
+                    finished = true;
+                }
+                else if(status == LL_STATUS_NO_ENOUGH_BYTES)
+                {
+                    *remainder = next;
+                    result = status;
+                    finished = true;
+                }
+                else
+                {
+                    callback(context, status, next, ll_has_data(status) ? message : NULL);
+                    position = next;
+                }
+            }
+        }
+    }
+
+    if(ok)
+    {
+        parallel.stop = true;
+        pthread_barrier_wait(&parallel.round_begin);
+    }
+    for(size_t i = 1; i < parallel.workers_count; i++)
+    {
+        pthread_join(parallel.workers[i].thread, NULL);
+    }
+    if(ok)
+    {
+        pthread_barrier_destroy(&parallel.round_begin);
+        pthread_barrier_destroy(&parallel.round_end);
+    }
+    pthread_mutex_destroy(&parallel.start_lock);
+    for(size_t i = 0; i < workers_allocated; i++)
+    {
+        free(parallel.workers[i].results);
+        free(parallel.workers[i].data);
+    }
+    free(parallel.workers);
+    free(data);
+    return result;
+}
+
+size_t ll_serialize_parallel(ll_message_info_t msg_info,
+                             const uint8_t* data_in,
+                             uint8_t* data_out,
+                             size_t threads)
+{
+    if(!data_in || !data_out || !ll_message_info_valid(msg_info))
+    {
+        return 0;
+    }
+
+    threads = ll_threads_count(threads);
+    if(threads > msg_info.size / LL_PARALLEL_PART_MIN)
+    {
+        threads = msg_info.size / LL_PARALLEL_PART_MIN;
+    }
+
+    //in COBS mode every block depends on previous ones
+    ll_parallel_part_t* parts = NULL;
+    if(threads >= 2 && msg_info.framing != LL_FRAMING_COBS)
+    {
+        parts = calloc(threads, sizeof(ll_parallel_part_t));
+    }
+    if(!parts)
+    {
+        return ll_serialize(msg_info, data_in, data_out);
+    }
+
+    size_t part_size = msg_info.size / threads;
+    for(size_t i = 0; i < threads; i++)
+    {
+        parts[i].msg_info = msg_info;
+        parts[i].data_in = data_in + i * part_size;
+        parts[i].size = i == threads - 1 ? msg_info.size - i * part_size : part_size;
+    }
+
+    //escaped size of every part gives its position in serialized message
+    ll_parts_run(parts, threads, ll_part_count);
+
+    size_t position = 1;
+    uint32_t checksum = 0;
+    for(size_t i = 0; i < threads; i++)
+    {
+        parts[i].data_out = data_out + position;
+        position += parts[i].escaped_size;
+        checksum = ll_crc32c_combine(checksum, parts[i].checksum, parts[i].size);
+    }
+
+    ll_parts_run(parts, threads, ll_part_escape);
+    free(parts);
+
+    data_out[0] = msg_info.begin_byte;
+    if(msg_info.checksum == LL_CHECKSUM_CRC32C)
+    {
+        uint8_t trailer[4];
+        for(size_t i = 0; i < sizeof(trailer); i++)
+        {
+            trailer[i] = (uint8_t)(checksum >> (8 * i));
+        }
+        position += ll_escape(msg_info, trailer, sizeof(trailer), data_out + position);
+    }
+    data_out[position] = msg_info.end_byte;
+    return position + 1;
+}
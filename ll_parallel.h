@@ -0,0 +1,185 @@
+/*
+    Multi-threaded processing of big byte streams (for example link captures).
+
+    ll_deserialize_parallel splits byte stream into chunks and every thread parses
+its chunk starting from the first position where message can start. It is not known
+in which state sequential parsing enters the chunk (message can start in previous
+chunk and end in this one, "begin byte" can be rejected and so on), so results of
+threads are speculative. After all threads end, results are merged: every message
+is taken from the thread only when sequential parsing reaches the same position where
+thread started parsing it or opens message at the same "begin byte" (bytes skipped
+before "begin byte" don't change result). Otherwise the message is parsed again.
+
+    In LL_FRAMING_REJECT mode escape state at the beginning of chunk is not known: "begin
+byte" after "reject byte" is a byte of message for sequential parsing which comes from
+previous bytes, but it opens message if parsing starts exactly there (for example after
+too long message). Thread tracks both states: it parses the second chain of messages from
+such "begin byte" until the chain reaches position of the first chain (at most 64 messages).
+
+    Chunk is at least 1 MB and holds at least 4 frames of maximal size, so messages
+which cross chunk boundaries are rare. Such message is parsed in the calling thread
+during merge (work of thread which started inside of it is wasted), the same happens
+when both chains of chunk don't reach position of sequential parsing (for example
+in damaged streams). Cost of this fallback is sequential parsing of that part of
+byte stream.
+
+    Result of parallel parsing is always the same as result of ll_deserialize_all.
+
+    ll_serialize_parallel counts escaped size of every part of message in parallel,
+calculates position of every part in serialized message and then escapes all parts
+in parallel. Result is always the same as result of ll_serialize.
+*/
+
+#ifndef LL_PARALLEL_H
+#define LL_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+
+/**
+ * @brief Callback which is called for every result of parsing.
+ * @param context context which was passed to parsing function
+ * @param status status returned by ll_deserialize, LL_STATUS_NO_MESSAGE and
+ * LL_STATUS_NO_ENOUGH_BYTES are never passed
+ * @param position position in byte stream where parsing of next message starts
+ * @param data parsed message with size of msg_info.size for LL_STATUS_SUCCESS and
+ * LL_STATUS_CHECKSUM_FAILURE, NULL otherwise. It is valid only during the call.
+ */
+typedef void (*ll_frame_callback_t)(void* context, ll_status_t status, size_t position, const uint8_t* data);
+
+/**
+ * @brief Callback which is called for every result of scanning.
+ * @param context context which was passed to ll_scan_all
+ * @param status the same as in ll_frame_callback_t
+ * @param position the same as in ll_frame_callback_t
+ * @param frame frame found by ll_scan, position of "begin byte" is counted from
+ * the beginning of byte stream. It is valid only during the call.
+ */
+typedef void (*ll_scan_callback_t)(void* context, ll_status_t status, size_t position, const ll_frame_scan_t* frame);
+
+/**
+ * @brief This function parses all messages from byte stream by calling ll_deserialize
+ * until the end of byte stream. Every next call starts at position returned by previous call
+ * in "remainder".
+ *
+ * @param msg_info message info
+ * @param byte_stream area of memory with size of byte_stream_size which will be parsed,
+ * if byte_stream == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param byte_stream_size byte stream size
+ * @param callback function which is called for every result in order of byte stream,
+ * if callback == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param context context passed to "callback"
+ * @param remainder pointer to position of uncompleted message at the end of byte stream
+ * or byte_stream_size if there is no such message,
+ * if remainder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_NO_ENOUGH_BYTES if byte stream ends in the middle of message,
+ * LL_STATUS_SUCCESS otherwise
+ */
+ll_status_t ll_deserialize_all(
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    ll_frame_callback_t callback,
+    void* context,
+    size_t* remainder
+);
+
+/**
+ * @brief This function does the same as ll_deserialize_all with ll_deserialize_filtered
+ * instead of ll_deserialize: only needed messages are passed to callback, other messages
+ * are validated without writing and are reported with data == NULL.
+ *
+ * @param msg_info message info
+ * @param filter the same as in ll_deserialize_filtered
+ * @param byte_stream the same as in ll_deserialize_all
+ * @param byte_stream_size byte stream size
+ * @param callback the same as in ll_deserialize_all, "data" is NULL for messages which are
+ * not matched by filter
+ * @param context context passed to "callback"
+ * @param remainder the same as in ll_deserialize_all
+ * @returns the same as ll_deserialize_all, LL_STATUS_BAD_PARAMS if filter is not valid
+ */
+ll_status_t ll_deserialize_filtered_all(
+    ll_message_info_t msg_info,
+    const ll_filter_t* filter,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    ll_frame_callback_t callback,
+    void* context,
+    size_t* remainder
+);
+
+/**
+ * @brief This function does the same as ll_deserialize_all with ll_scan instead of
+ * ll_deserialize: frames are found and validated, but messages are not copied.
+ *
+ * @param msg_info message info
+ * @param byte_stream the same as in ll_deserialize_all
+ * @param byte_stream_size byte stream size
+ * @param callback function which is called for every result in order of byte stream,
+ * if callback == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param context context passed to "callback"
+ * @param remainder the same as in ll_deserialize_all
+ * @returns the same as ll_deserialize_all
+ */
+ll_status_t ll_scan_all(
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    ll_scan_callback_t callback,
+    void* context,
+    size_t* remainder
+);
+
+/**
+ * @brief This function does the same as ll_deserialize_all using several threads.
+ * Callback is called from the calling thread, in the same order and with the same
+ * arguments as in ll_deserialize_all.
+ *
+ * @param msg_info message info
+ * @param byte_stream the same as in ll_deserialize_all
+ * @param byte_stream_size byte stream size
+ * @param threads quantity of threads, 0 means quantity of online CPUs
+ * @param callback the same as in ll_deserialize_all
+ * @param context context passed to "callback"
+ * @param remainder the same as in ll_deserialize_all
+ * @returns the same as ll_deserialize_all or LL_STATUS_BAD_PARAMS if threads or memory
+ * can't be allocated (callback is not called in this case)
+ */
+ll_status_t ll_deserialize_parallel(
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    size_t threads,
+    ll_frame_callback_t callback,
+    void* context,
+    size_t* remainder
+);
+
+/**
+ * @brief This function does the same as ll_serialize using several threads. It is useful
+ * for big messages (megabytes), small messages and messages in LL_FRAMING_COBS mode
+ * are serialized by ll_serialize in the calling thread.
+ *
+ * @param msg_info message info
+ * @param data_in the same as in ll_serialize
+ * @param data_out the same as in ll_serialize
+ * @param threads quantity of threads, 0 means quantity of online CPUs
+ * @returns the same as ll_serialize
+ */
+size_t ll_serialize_parallel(
+    ll_message_info_t msg_info,
+    const uint8_t* data_in,
+    uint8_t* data_out,
+    size_t threads
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_PARALLEL_H
@@ -0,0 +1,281 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_patch.h"
+#include "ll_crc32c.h"
+
+#include <string.h>
+
+#define LL_PATCH_CHECKSUM_SIZE 4
+
+//the same as maximal quantity of bytes in COBS block in ll_protocol.c
+#define LL_PATCH_COBS_BLOCK_MAX 254
+
+//checksum of message which is not bigger is calculated again instead of updating
+#define LL_PATCH_CRC_FULL 4096
+
+//difference of changed bytes is collected by parts of this size
+#define LL_PATCH_CRC_PART 256
+
+
+static bool ll_patch_is_escaped(ll_message_info_t msg_info, uint8_t byte)
+{
+    return    byte == msg_info.begin_byte
+           || byte == msg_info.end_byte
+           || byte == msg_info.reject_byte;
+}
+
+static inline unsigned ll_patch_popcount(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_popcountll(bits);
+#else
+    unsigned count = 0;
+    for(; bits; bits &= bits - 1)
+    {
+        count++;
+    }
+    return count;
+#endif
+}
+
+//position of content byte in frame, "i" can be equal to content_size (position of "end byte")
+static size_t ll_patch_position(const ll_patch_t* patch, size_t i)
+{
+    uint64_t mask = (i % 64) ? (uint64_t)-1 >> (64 - i % 64) : 0;
+    return 1 + i + patch->before[i / 64] + ll_patch_popcount(patch->escaped[i / 64] & mask);
+}
+
+//builds escape map of content bytes from "begin" to "end" and counters of next words
+static void ll_patch_map(ll_patch_t* patch, size_t begin, size_t end)
+{
+    //empty content (message of size 0 without checksum) has no escaped bytes
+    if(begin == end)
+    {
+        return;
+    }
+
+    size_t words = (patch->content_size + 63) / 64;
+    unsigned old_count = 0;
+    unsigned new_count = 0;
+    for(size_t w = begin / 64; w <= (end - 1) / 64; w++)
+    {
+        old_count += ll_patch_popcount(patch->escaped[w]);
+        uint64_t bits = 0;
+        size_t last = (w + 1) * 64 < patch->content_size ? (w + 1) * 64 : patch->content_size;
+        for(size_t i = w * 64; i < last; i++)
+        {
+            if(ll_patch_is_escaped(patch->msg_info, patch->content[i]))
+            {
+                bits |= (uint64_t)1 << (i % 64);
+            }
+        }
+        patch->escaped[w] = bits;
+        new_count += ll_patch_popcount(bits);
+    }
+    //counters after changed words are the same if quantity of escaped bytes is not changed
+    if(new_count == old_count)
+    {
+        words = (end - 1) / 64 + 1;
+    }
+    for(size_t w = begin / 64; w < words; w++)
+    {
+        patch->before[w + 1] = patch->before[w] + ll_patch_popcount(patch->escaped[w]);
+    }
+}
+
+static void ll_patch_rebuild(ll_patch_t* patch)
+{
+    patch->frame_size = ll_serialize(patch->msg_info, patch->content, patch->frame);
+    patch->rebuilds++;
+}
+
+//changes content bytes in LL_FRAMING_REJECT and LL_FRAMING_XOR modes
+static void ll_patch_escaped_range(ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size)
+{
+    size_t begin = ll_patch_position(patch, offset);
+    size_t end = ll_patch_position(patch, offset + size);
+    size_t escaped_size = ll_sizeof_escaped(patch->msg_info, data, size);
+    if(escaped_size != end - begin)
+    {
+        //the rest of frame with "end byte" is moved only when escaped bytes are added or removed
+        memmove(patch->frame + begin + escaped_size, patch->frame + end, patch->frame_size - end);
+        patch->frame_size = patch->frame_size - (end - begin) + escaped_size;
+        patch->shifts++;
+    }
+    ll_escape(patch->msg_info, data, size, patch->frame + begin);
+    memcpy(patch->content + offset, data, size);
+    ll_patch_map(patch, offset, offset + size);
+}
+
+//changes content bytes in LL_FRAMING_COBS mode
+static void ll_patch_cobs_range(ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size)
+{
+    uint8_t end_byte = patch->msg_info.end_byte;
+    for(size_t i = 0; i < size; i++)
+    {
+        if((data[i] == end_byte) != (patch->content[offset + i] == end_byte))
+        {
+            memcpy(patch->content + offset, data, size);
+            ll_patch_rebuild(patch);
+            return;
+        }
+    }
+    memcpy(patch->content + offset, data, size);
+
+    //"end bytes" are not changed, so only bytes inside of blocks are copied
+    size_t position = 1;
+    size_t content_iter = 0;
+    while(content_iter < offset + size)
+    {
+        size_t run = (size_t)(patch->frame[position] ^ end_byte) - 1;
+        size_t first = offset > content_iter ? offset : content_iter;
+        size_t last = offset + size < content_iter + run ? offset + size : content_iter + run;
+        if(first < last)
+        {
+            memcpy(patch->frame + position + 1 + (first - content_iter), data + (first - offset), last - first);
+        }
+        position += 1 + run;
+        content_iter += run;
+        if(run != LL_PATCH_COBS_BLOCK_MAX)
+        {
+            //implied "end byte"
+            content_iter++;
+        }
+    }
+}
+
+static void ll_patch_range(ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size)
+{
+    if(patch->msg_info.framing == LL_FRAMING_COBS)
+    {
+        ll_patch_cobs_range(patch, offset, data, size);
+    }
+    else
+    {
+        ll_patch_escaped_range(patch, offset, data, size);
+    }
+}
+
+//returns checksum of message after change, it is calculated before content is changed
+static uint32_t ll_patch_checksum(const ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size)
+{
+    uint32_t checksum = 0;
+    const uint8_t* trailer = patch->content + patch->msg_info.size;
+    for(size_t i = 0; i < LL_PATCH_CHECKSUM_SIZE; i++)
+    {
+        checksum |= (uint32_t)trailer[i] << (8 * i);
+    }
+
+    //checksum of changed message is old checksum xor CRC32C register (without initial value
+    //and final xor) of difference of bytes followed by zero bytes till the end of message
+    uint32_t difference = 0;
+    for(size_t i = 0; i < size; i += LL_PATCH_CRC_PART)
+    {
+        uint8_t part[LL_PATCH_CRC_PART];
+        size_t part_size = size - i < LL_PATCH_CRC_PART ? size - i : LL_PATCH_CRC_PART;
+        for(size_t j = 0; j < part_size; j++)
+        {
+            part[j] = data[i + j] ^ patch->content[offset + i + j];
+        }
+        difference = ~ll_crc32c(~difference, part, part_size);
+    }
+    return checksum ^ ll_crc32c_combine(difference, 0, patch->msg_info.size - offset - size);
+}
+
+ll_status_t ll_patch_init(ll_patch_t* patch, ll_message_info_t msg_info, const uint8_t* data)
+{
+    if(!patch || !data || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memset(patch, 0, sizeof(*patch));
+    patch->msg_info = msg_info;
+    patch->content_size = msg_info.size + (msg_info.checksum == LL_CHECKSUM_CRC32C ? LL_PATCH_CHECKSUM_SIZE : 0);
+    patch->content = malloc(patch->content_size + 1);
+    patch->frame = malloc(ll_sizeof_serialized_max(msg_info));
+    if(msg_info.framing != LL_FRAMING_COBS)
+    {
+        //one more word for position of "end byte" when content size is multiple of 64
+        size_t words = patch->content_size / 64 + 1;
+        patch->escaped = calloc(words, sizeof(uint64_t));
+        patch->before = calloc(words + 1, sizeof(uint32_t));
+    }
+    if(   !patch->content
+       || !patch->frame
+       || (msg_info.framing != LL_FRAMING_COBS && (!patch->escaped || !patch->before)))
+    {
+        ll_patch_destroy(patch);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    memcpy(patch->content, data, msg_info.size);
+    if(msg_info.checksum == LL_CHECKSUM_CRC32C)
+    {
+        uint32_t checksum = ll_crc32c(0, data, msg_info.size);
+        for(size_t i = 0; i < LL_PATCH_CHECKSUM_SIZE; i++)
+        {
+            patch->content[msg_info.size + i] = (uint8_t)(checksum >> (8 * i));
+        }
+    }
+    if(msg_info.framing != LL_FRAMING_COBS)
+    {
+        ll_patch_map(patch, 0, patch->content_size);
+    }
+    patch->frame_size = ll_serialize(msg_info, data, patch->frame);
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_patch_destroy(ll_patch_t* patch)
+{
+    if(!patch)
+    {
+        return;
+    }
+    free(patch->content);
+    free(patch->frame);
+    free(patch->escaped);
+    free(patch->before);
+    patch->content = NULL;
+    patch->frame = NULL;
+    patch->escaped = NULL;
+    patch->before = NULL;
+}
+
+ll_status_t ll_patch_update(ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size)
+{
+    if(   !patch || (!data && size)
+       || offset > patch->msg_info.size || size > patch->msg_info.size - offset)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    if(size == 0)
+    {
+        return LL_STATUS_SUCCESS;
+    }
+
+    if(patch->msg_info.checksum != LL_CHECKSUM_CRC32C)
+    {
+        ll_patch_range(patch, offset, data, size);
+        return LL_STATUS_SUCCESS;
+    }
+
+    uint32_t checksum = 0;
+    if(patch->msg_info.size > LL_PATCH_CRC_FULL)
+    {
+        checksum = ll_patch_checksum(patch, offset, data, size);
+    }
+    ll_patch_range(patch, offset, data, size);
+    if(patch->msg_info.size <= LL_PATCH_CRC_FULL)
+    {
+        checksum = ll_crc32c(0, patch->content, patch->msg_info.size);
+    }
+
+    uint8_t trailer[LL_PATCH_CHECKSUM_SIZE];
+    for(size_t i = 0; i < LL_PATCH_CHECKSUM_SIZE; i++)
+    {
+        trailer[i] = (uint8_t)(checksum >> (8 * i));
+    }
+    ll_patch_range(patch, patch->msg_info.size, trailer, LL_PATCH_CHECKSUM_SIZE);
+    return LL_STATUS_SUCCESS;
+}
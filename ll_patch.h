@@ -0,0 +1,92 @@
+/*
+    Serialized frame which is updated in place when part of message changes (for example
+telemetry where only counters change every cycle). Only changed bytes are escaped again,
+so update costs are proportional to size of changed part instead of size of message.
+
+    LL_FRAMING_REJECT and LL_FRAMING_XOR: every byte of message (and checksum) takes one
+byte of frame or two bytes if it is escaped. Escape map (one bit per byte and quantity of
+escaped bytes before every 64 bytes) gives position of any byte in frame. Changed bytes
+are escaped again to their place, and the rest of frame is moved only if quantity of
+escaped bytes in changed part has changed.
+
+    LL_FRAMING_COBS: changed bytes are copied to their places in blocks if no byte becomes
+or stops being "end byte". Otherwise blocks are changed and frame is serialized again.
+
+    With LL_CHECKSUM_CRC32C checksum is updated too: for small messages it is calculated
+again, for big messages it is changed by CRC32C of difference of changed bytes (CRC32C is
+linear), so unchanged bytes are not read. Checksum is updated in frame as changed part.
+
+Example:
+    ll_patch_t patch;
+    ll_patch_init(&patch, msg_info, telemetry);
+
+    //every cycle
+    ll_patch_update(&patch, offsetof(telemetry_t, counter), (const uint8_t*)&counter, sizeof(counter));
+    write(fd, patch.frame, patch.frame_size);
+
+    ll_patch_destroy(&patch);
+*/
+
+#ifndef LL_PATCH_H
+#define LL_PATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+
+typedef struct
+{
+    ll_message_info_t msg_info;
+    uint8_t*          content;    //message and checksum which are serialized in frame
+    size_t            content_size;
+    uint8_t*          frame;      //serialized frame, capacity is ll_sizeof_serialized_max
+    size_t            frame_size;
+    uint64_t*         escaped;    //escape map: bit for every byte of content
+    uint32_t*         before;     //quantity of escaped bytes before every 64 bytes of content
+    uint64_t          shifts;     //quantity of updates which moved the rest of frame
+    uint64_t          rebuilds;   //quantity of updates which serialized the whole frame
+} ll_patch_t;
+
+
+/**
+ * @brief This function allocates memory and serializes message to frame.
+ * @param patch patch,
+ * if patch == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info,
+ * if it is not valid (see ll_message_info_valid) then function does nothing and
+ * returns LL_STATUS_BAD_PARAMS
+ * @param data message with size of msg_info.size,
+ * if data == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_patch_init(ll_patch_t* patch, ll_message_info_t msg_info, const uint8_t* data);
+
+/**
+ * @brief This function frees memory of patch.
+ * @param patch patch,
+ * if patch == NULL then function does nothing
+ */
+void ll_patch_destroy(ll_patch_t* patch);
+
+/**
+ * @brief This function changes part of message and updates frame, after that frame is
+ * the same as ll_serialize gives for changed message.
+ * @param patch patch initialized by ll_patch_init,
+ * if patch == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param offset offset of changed part in message
+ * @param data new bytes of changed part,
+ * if data == NULL and size > 0 then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param size size of changed part,
+ * if offset + size > msg_info.size then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS
+ */
+ll_status_t ll_patch_update(ll_patch_t* patch, size_t offset, const uint8_t* data, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_PATCH_H
@@ -1,15 +1,428 @@
 #include "ll_protocol.h"
+#include "ll_crc32c.h"
+#include "ll_latency.h"
 
+#include <string.h>
 
-size_t ll_sizeof_serialized(ll_message_info_t msg_info, const uint8_t* data)
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+
+//maximal quantity of message bytes in one COBS block
+#define LL_COBS_BLOCK_MAX 254
+
+//escaped bytes in LL_FRAMING_XOR mode are XORed with this value
+#define LL_XOR_MASK 0x20
+
+//size of checksum which is added after message bytes
+#define LL_CHECKSUM_SIZE 4
+
+//with checksum message is serialized by chunks of this size, so checksum
+//is calculated and chunk is escaped while it is still in L1 cache
+#define LL_CHECKSUM_CHUNK 256
+
+//long runs of parsed message are copied by parts of this size, so every part is added
+//to checksum while it is still in L1 cache
+#define LL_CHECKSUM_COPY 4096
+
+
+//states of ll_decoder_t
+enum
+{
+    LL_DECODER_IDLE,          //waiting for "begin byte"
+    LL_DECODER_IDLE_REJECTED, //waiting for "begin byte", previous byte was "reject byte"
+    LL_DECODER_DATA,          //inside of message
+    LL_DECODER_ESCAPED,       //inside of message, previous byte was "reject byte"
+    LL_DECODER_COBS_CODE,     //waiting for COBS code byte
+    LL_DECODER_COBS_BLOCK,    //inside of COBS block
+    LL_DECODER_COBS_SKIP      //waiting for "end byte" after error
+};
+
+//states of ll_encoder_t
+enum
+{
+    LL_ENCODER_BEGIN,      //"begin byte" is the next
+    LL_ENCODER_DATA,       //message byte is the next
+    LL_ENCODER_ESCAPED,    //escaped byte after "reject byte" is the next
+    LL_ENCODER_COBS_CODE,  //COBS code byte is the next
+    LL_ENCODER_COBS_BLOCK, //byte of COBS block is the next
+    LL_ENCODER_END,        //"end byte" is the next
+    LL_ENCODER_DONE        //whole message has been taken
+};
+
+
+//short runs of scanned message are collected to this buffer and added to checksum together,
+//because every call of ll_crc32c has slow processing of unaligned head and tail
+#define LL_SCAN_STAGE 256
+
+
+//bytes of parsed message, bytes after "data_size" bytes are checksum. If "use_checksum" is
+//true, bytes are added to "checksum" while message is parsed: written bytes are read again
+//by chunks while they are in L1 cache ("checked" bytes of "data" are added already). If "data"
+//is NULL message is only scanned: bytes are not written, but they are added to "checksum".
+//If "filter" is not NULL, first "filter_size" bytes are checked by it and the rest of message
+//is only scanned if they don't match
+typedef struct
+{
+    uint8_t*           data;
+    size_t             data_size;
+    uint8_t            trailer[LL_CHECKSUM_SIZE];
+    size_t             begin;         //position of "begin byte" of message
+    size_t             count;         //quantity of bytes which were put
+    const ll_filter_t* filter;
+    size_t             filter_size;
+    bool               matched;
+    bool               use_checksum;
+    uint32_t           checksum;
+    size_t             checked;
+    size_t             staged;
+    uint8_t            stage[LL_SCAN_STAGE];
+} ll_frame_out_t;
+
+//byte stream which consists of several spans, positions in it are counted
+//from the beginning of the first span
+typedef struct
+{
+    const ll_span_t* spans;
+    size_t           spans_count;
+    size_t           size;
+} ll_stream_t;
+
+//state of COBS encoder, if "out" is NULL encoder only counts bytes
+typedef struct
+{
+    uint8_t* out;
+    uint8_t* code;
+    size_t   size;
+    size_t   run;
+} ll_cobs_encoder_t;
+
+
+//returns position of first byte equal to "a" or "b" or "size" if there is no such byte
+static size_t ll_find_either(const uint8_t* data, size_t size, uint8_t a, uint8_t b)
+{
+    size_t i = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+    const __m128i va = _mm_set1_epi8((char)a);
+    const __m128i vb = _mm_set1_epi8((char)b);
+    for(; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if(mask)
+        {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < size; i++)
+    {
+        if(data[i] == a || data[i] == b)
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+//returns position of first control byte or "size" if there is no such byte
+static size_t ll_find_control(ll_message_info_t msg_info, const uint8_t* data, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__) && defined(__GNUC__)
+    const __m128i vbegin = _mm_set1_epi8((char)msg_info.begin_byte);
+    const __m128i vend = _mm_set1_epi8((char)msg_info.end_byte);
+    const __m128i vreject = _mm_set1_epi8((char)msg_info.reject_byte);
+    for(; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vbegin), _mm_cmpeq_epi8(v, vend)),
+                                  _mm_cmpeq_epi8(v, vreject));
+        int mask = _mm_movemask_epi8(eq);
+        if(mask)
+        {
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; i < size; i++)
+    {
+        if(   data[i] == msg_info.begin_byte
+           || data[i] == msg_info.end_byte
+           || data[i] == msg_info.reject_byte)
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+static inline bool ll_is_control_byte(ll_message_info_t msg_info, uint8_t byte)
+{
+    return    byte == msg_info.begin_byte
+           || byte == msg_info.end_byte
+           || byte == msg_info.reject_byte;
+}
+
+//in LL_FRAMING_XOR mode escaped control bytes must not become control bytes
+static bool ll_xor_info_valid(ll_message_info_t msg_info)
+{
+    return    !ll_is_control_byte(msg_info, msg_info.begin_byte ^ LL_XOR_MASK)
+           && !ll_is_control_byte(msg_info, msg_info.end_byte ^ LL_XOR_MASK)
+           && !ll_is_control_byte(msg_info, msg_info.reject_byte ^ LL_XOR_MASK);
+}
+
+bool ll_message_info_valid(ll_message_info_t msg_info)
+{
+    if(   msg_info.framing >= LL_FRAMING_ENUM_SIZE
+       || msg_info.checksum >= LL_CHECKSUM_ENUM_SIZE)
+    {
+        return false;
+    }
+    return msg_info.framing != LL_FRAMING_XOR || ll_xor_info_valid(msg_info);
+}
+
+static size_t ll_trailer_size(ll_message_info_t msg_info)
+{
+    return msg_info.checksum == LL_CHECKSUM_CRC32C ? LL_CHECKSUM_SIZE : 0;
+}
+
+//checksum is written in little endian byte order
+static void ll_store_checksum(uint8_t* trailer, uint32_t checksum)
+{
+    for(size_t i = 0; i < LL_CHECKSUM_SIZE; i++)
+    {
+        trailer[i] = (uint8_t)(checksum >> (8 * i));
+    }
+}
+
+static uint32_t ll_load_checksum(const uint8_t* trailer)
+{
+    uint32_t checksum = 0;
+    for(size_t i = 0; i < LL_CHECKSUM_SIZE; i++)
+    {
+        checksum |= (uint32_t)trailer[i] << (8 * i);
+    }
+    return checksum;
+}
+
+static void ll_scan_flush(ll_frame_out_t* out)
+{
+    out->checksum = ll_crc32c(out->checksum, out->stage, out->staged);
+    out->staged = 0;
+}
+
+//checks first bytes of message by filter, message is only scanned after that if they don't match
+static void ll_filter_check(ll_frame_out_t* out)
+{
+    const ll_filter_t* filter = out->filter;
+    out->filter = NULL;
+    out->matched = filter->predicate
+                   ? filter->predicate(filter->context, out->data, out->filter_size)
+                   : (filter->first_bytes[out->data[0] >> 3] >> (out->data[0] & 7)) & 1;
+    if(!out->matched)
+    {
+        //bytes which were written and not checked yet are added to checksum as scanned ones
+        size_t count = out->count < out->data_size ? out->count : out->data_size;
+        count -= out->checked;
+        if(out->use_checksum && count <= LL_SCAN_STAGE)
+        {
+            memcpy(out->stage, out->data + out->checked, count);
+            out->staged = count;
+        }
+        else if(out->use_checksum)
+        {
+            out->checksum = ll_crc32c(out->checksum, out->data + out->checked, count);
+        }
+        out->data = NULL;
+    }
+}
+
+//adds written bytes of message till "end" to checksum when there are enough of them
+static inline void ll_check_data(ll_frame_out_t* out, size_t end)
+{
+    if(out->use_checksum && end - out->checked >= LL_CHECKSUM_CHUNK)
+    {
+        out->checksum = ll_crc32c(out->checksum, out->data + out->checked, end - out->checked);
+        out->checked = end;
+    }
+}
+
+static inline void ll_put_byte(ll_frame_out_t* out, size_t message_iter, uint8_t byte)
+{
+    out->count = message_iter + 1;
+    if(message_iter < out->data_size)
+    {
+        if(out->data)
+        {
+            out->data[message_iter] = byte;
+            ll_check_data(out, message_iter + 1);
+        }
+        else if(out->use_checksum)
+        {
+            if(out->staged == LL_SCAN_STAGE)
+            {
+                ll_scan_flush(out);
+            }
+            out->stage[out->staged++] = byte;
+        }
+    }
+    else
+    {
+        out->trailer[message_iter - out->data_size] = byte;
+    }
+    if(out->filter && out->count >= out->filter_size)
+    {
+        ll_filter_check(out);
+    }
+}
+
+static void ll_put_bytes(ll_frame_out_t* out, size_t message_iter, const uint8_t* bytes, size_t count)
+{
+    //run is split after bytes checked by filter, so the rest of not matched message is only scanned
+    if(out->filter && message_iter < out->filter_size && count > out->filter_size - message_iter)
+    {
+        size_t head = out->filter_size - message_iter;
+        ll_put_bytes(out, message_iter, bytes, head);
+        message_iter += head;
+        bytes += head;
+        count -= head;
+    }
+
+    if(count > 0)
+    {
+        out->count = message_iter + count;
+    }
+    if(message_iter < out->data_size)
+    {
+        size_t data_count = out->data_size - message_iter;
+        if(data_count > count)
+        {
+            data_count = count;
+        }
+        if(out->data)
+        {
+            //long runs are copied by parts, so every part is added to checksum from L1 cache
+            size_t part_max = out->use_checksum ? LL_CHECKSUM_COPY : data_count;
+            for(size_t i = 0; i < data_count; i += part_max)
+            {
+                size_t part = data_count - i < part_max ? data_count - i : part_max;
+                memcpy(out->data + message_iter + i, bytes + i, part);
+                ll_check_data(out, message_iter + i + part);
+            }
+        }
+        else if(out->use_checksum)
+        {
+            if(out->staged + data_count > LL_SCAN_STAGE)
+            {
+                ll_scan_flush(out);
+            }
+            if(data_count >= LL_SCAN_STAGE)
+            {
+                out->checksum = ll_crc32c(out->checksum, bytes, data_count);
+            }
+            else
+            {
+                memcpy(out->stage + out->staged, bytes, data_count);
+                out->staged += data_count;
+            }
+        }
+        message_iter += data_count;
+        bytes += data_count;
+        count -= data_count;
+    }
+    if(count > 0)
+    {
+        memcpy(out->trailer + (message_iter - out->data_size), bytes, count);
+    }
+    if(out->filter && out->count >= out->filter_size)
+    {
+        ll_filter_check(out);
+    }
+}
+
+
+//returns pointer to byte at "position" and quantity of contiguous bytes from it in "size"
+static const uint8_t* ll_stream_at(const ll_stream_t* stream, size_t position, size_t* size)
+{
+    for(size_t i = 0; i < stream->spans_count; i++)
+    {
+        if(position < stream->spans[i].size)
+        {
+            *size = stream->spans[i].size - position;
+            return stream->spans[i].data + position;
+        }
+        position -= stream->spans[i].size;
+    }
+    *size = 0;
+    return NULL;
+}
+
+static inline uint8_t ll_stream_byte(const ll_stream_t* stream, size_t position)
+{
+    size_t size;
+    return *ll_stream_at(stream, position, &size);
+}
+
+//returns position of first byte equal to "a" or "b" from "begin" to "end" or "end" if there is no such byte
+static size_t ll_stream_find(const ll_stream_t* stream, size_t begin, size_t end, uint8_t a, uint8_t b)
+{
+    while(begin < end)
+    {
+        size_t size;
+        const uint8_t* data = ll_stream_at(stream, begin, &size);
+        if(size > end - begin)
+        {
+            size = end - begin;
+        }
+
+        size_t found;
+        if(a == b)
+        {
+            //memchr is usually faster than ll_find_either
+            const uint8_t* byte = memchr(data, a, size);
+            found = byte ? (size_t)(byte - data) : size;
+        }
+        else
+        {
+            found = ll_find_either(data, size, a, b);
+        }
+
+        if(found < size)
+        {
+            return begin + found;
+        }
+        begin += size;
+    }
+    return end;
+}
+
+//puts "count" bytes from "position" of byte stream to parsed message
+static void ll_stream_put(const ll_stream_t* stream, size_t position, size_t count, ll_frame_out_t* out, size_t message_iter)
+{
+    while(count > 0)
+    {
+        size_t size;
+        const uint8_t* data = ll_stream_at(stream, position, &size);
+        if(size > count)
+        {
+            size = count;
+        }
+        ll_put_bytes(out, message_iter, data, size);
+        position += size;
+        message_iter += size;
+        count -= size;
+    }
+}
+
+size_t ll_sizeof_escaped(ll_message_info_t msg_info, const uint8_t* data, size_t size)
 {
-    if(!data)
+    if(!data || msg_info.framing == LL_FRAMING_COBS)
     {
         return 0;
     }
-    //+2 is for msg_info.begin_byte at the beginning and msg_info.end_byte at the end of message
-    size_t result = msg_info.size + 2;
-    for(size_t i = 0; i < msg_info.size; i++)
+    size_t result = size;
+    for(size_t i = 0; i < size; i++)
     {
         if(   data[i] == msg_info.begin_byte
            || data[i] == msg_info.end_byte
@@ -21,19 +434,17 @@ size_t ll_sizeof_serialized(ll_message_info_t msg_info, const uint8_t* data)
     return result;
 }
 
-void ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* data_out)
+size_t ll_escape(ll_message_info_t msg_info, const uint8_t* data_in, size_t size, uint8_t* data_out)
 {
-    if(!data_in || !data_out)
+    if(!data_in || !data_out || msg_info.framing == LL_FRAMING_COBS)
     {
-        return;
+        return 0;
     }
 
     uint8_t* tmp_out = data_out;
+    const uint8_t mask = msg_info.framing == LL_FRAMING_XOR ? LL_XOR_MASK : 0;
 
-    *data_out = msg_info.begin_byte;
-    tmp_out++;
-
-    for(size_t i = 0; i < msg_info.size; i++)
+    for(size_t i = 0; i < size; i++)
     {
         if(   data_in[i] == msg_info.begin_byte
            || data_in[i] == msg_info.end_byte
@@ -41,7 +452,7 @@ void ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* d
         {
             *tmp_out = msg_info.reject_byte;
             tmp_out++;
-            *tmp_out = data_in[i];
+            *tmp_out = data_in[i] ^ mask;
             tmp_out++;
         }
         else
@@ -50,126 +461,1132 @@ void ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* d
             tmp_out++;
         }
     }
-    *tmp_out = msg_info.end_byte;
+    return (size_t)(tmp_out - data_out);
 }
 
-ll_status_t ll_deserialize(ll_message_info_t msg_info,
-                           const uint8_t* byte_stream, 
-                           size_t byte_stream_size, 
-                           uint8_t* data_out,
-                           size_t* remainder)
+
+static void ll_cobs_open_block(ll_cobs_encoder_t* encoder)
 {
-    if(!byte_stream || !data_out || !remainder)
+    encoder->code = encoder->out;
+    if(encoder->out)
     {
-        return LL_STATUS_BAD_PARAMS;
+        encoder->out++;
     }
+    encoder->size++;
+    encoder->run = 0;
+}
 
-    *remainder = 0;
-    bool message_opened = false;
-    bool reject = false;
-    bool ignore_previous = false;
-    size_t message_iter = 0;
-    uint8_t byte = msg_info.end_byte;
-    uint8_t previous_byte = msg_info.end_byte;
+static void ll_cobs_close_block(ll_message_info_t msg_info, ll_cobs_encoder_t* encoder)
+{
+    if(encoder->code)
+    {
+        *encoder->code = (uint8_t)((encoder->run + 1) ^ msg_info.end_byte);
+    }
+}
+
+static void ll_cobs_begin(ll_cobs_encoder_t* encoder, uint8_t* data_out)
+{
+    encoder->out = data_out;
+    encoder->size = 0;
+    ll_cobs_open_block(encoder);
+}
 
-    for(size_t i = 0; i < byte_stream_size; i++)
+//encodes next part of message, blocks can continue from one part to another
+static void ll_cobs_feed(ll_message_info_t msg_info, ll_cobs_encoder_t* encoder, const uint8_t* data_in, size_t size)
+{
+    while(size > 0)
     {
-        previous_byte = byte;
-        byte = byte_stream[i];
+        //block of maximal length has no implied "end byte", so the next block
+        //is opened only when there are bytes to put in it
+        if(encoder->run == LL_COBS_BLOCK_MAX)
+        {
+            ll_cobs_close_block(msg_info, encoder);
+            ll_cobs_open_block(encoder);
+        }
 
-        if(  !message_opened
-           && byte == msg_info.begin_byte
-           && previous_byte != msg_info.reject_byte)
+        size_t max = LL_COBS_BLOCK_MAX - encoder->run;
+        if(max > size)
         {
-            message_opened = true;
+            max = size;
         }
+        //memchr is vectorized by most of C libraries, so runs are found much faster
+        //than by checking every byte
+        const uint8_t* found = memchr(data_in, msg_info.end_byte, max);
+        size_t run = found ? (size_t)(found - data_in) : max;
 
-        if(!message_opened)
+        if(encoder->out)
         {
-            continue;
+            memcpy(encoder->out, data_in, run);
+            encoder->out += run;
         }
+        encoder->size += run;
+        encoder->run += run;
+        data_in += run;
+        size -= run;
 
-        if(message_iter == msg_info.size)
+        if(found)
         {
-            message_opened = false;
-            if(byte == msg_info.end_byte)
-            {
-                if(i == byte_stream_size - 1)
-                {
-                    *remainder = 0;
-                }
-                else
-                {
-                    *remainder = i + 1;
-                }
-                return LL_STATUS_SUCCESS;
-            }
-            else
-            {
-                *remainder = i;
-                return LL_STATUS_MESSAGE_TOO_LONG;
-            }
-            message_iter = 0;
-            continue;
+            //block after implied "end byte" is always written, even if it is empty
+            ll_cobs_close_block(msg_info, encoder);
+            ll_cobs_open_block(encoder);
+            data_in++;
+            size--;
         }
+    }
+}
+
+static void ll_cobs_finish(ll_message_info_t msg_info, ll_cobs_encoder_t* encoder)
+{
+    ll_cobs_close_block(msg_info, encoder);
+}
+
+static ll_status_t ll_cobs_decode(ll_message_info_t msg_info,
+                                  const ll_stream_t* stream,
+                                  size_t begin,
+                                  size_t end,
+                                  ll_frame_out_t* out)
+{
+    size_t message_iter = 0;
+    size_t i = begin;
 
-        if(   byte == msg_info.end_byte
-           && previous_byte != msg_info.reject_byte
-           && !ignore_previous
-           && message_iter < msg_info.size)
+    while(i < end)
+    {
+        //encoded bytes are never equal to "end byte", so code is never 0
+        size_t run = (size_t)(ll_stream_byte(stream, i) ^ msg_info.end_byte) - 1;
+        i++;
+
+        if(run > end - i)
         {
-            message_opened = false;
-            reject = false;
-            message_iter = 0;
-            *remainder = i + 1;
             return LL_STATUS_MESSAGE_TOO_SHORT;
         }
-
-        //it seems that it can be optimized
-        //by combining this "if()"
-        if(   (byte != msg_info.reject_byte
-           && byte != msg_info.begin_byte
-           && byte != msg_info.end_byte
-           && previous_byte != msg_info.reject_byte)
-           ||
-             (byte != msg_info.reject_byte
-           && byte != msg_info.begin_byte
-           && byte != msg_info.end_byte
-           && ignore_previous))
+        if(run > msg_info.size - message_iter)
         {
-            data_out[message_iter++] = byte;
-            ignore_previous = false;
-            continue;
-         }
+            return LL_STATUS_MESSAGE_TOO_LONG;
+        }
+        ll_stream_put(stream, i, run, out, message_iter);
+        message_iter += run;
+        i += run;
 
-        //with this "if()"
-        if(reject)
+        if(run != LL_COBS_BLOCK_MAX && i < end)
         {
-            data_out[message_iter++] = byte;
-            if(byte == msg_info.reject_byte)
+            if(message_iter == msg_info.size)
             {
-                ignore_previous = true;
+                return LL_STATUS_MESSAGE_TOO_LONG;
             }
-            reject = false;
-            continue;
+            ll_put_byte(out, message_iter++, msg_info.end_byte);
         }
+    }
+
+    return message_iter == msg_info.size ? LL_STATUS_SUCCESS : LL_STATUS_MESSAGE_TOO_SHORT;
+}
 
-        if(byte == msg_info.reject_byte && (previous_byte != msg_info.reject_byte || ignore_previous))
+static ll_status_t ll_cobs_deserialize(ll_message_info_t msg_info,
+                                       const ll_stream_t* stream,
+                                       ll_frame_out_t* out,
+                                       size_t* remainder)
+{
+    size_t byte_stream_size = stream->size;
+    size_t begin_pos = ll_stream_find(stream, 0, byte_stream_size, msg_info.begin_byte, msg_info.begin_byte);
+    if(begin_pos == byte_stream_size)
+    {
+        *remainder = byte_stream_size;
+        return LL_STATUS_NO_MESSAGE;
+    }
+
+    out->begin = begin_pos;
+    size_t encoded_max = ll_sizeof_serialized_max(msg_info) - 2;
+    size_t end_pos = ll_stream_find(stream, begin_pos + 1, byte_stream_size, msg_info.end_byte, msg_info.end_byte);
+    if(end_pos == byte_stream_size)
+    {
+        if(byte_stream_size - begin_pos - 1 > encoded_max)
         {
-            reject = true;
-            if(ignore_previous)
-            {
-                ignore_previous = false;
-            }
+            *remainder = byte_stream_size;
+            return LL_STATUS_MESSAGE_TOO_LONG;
         }
+        *remainder = begin_pos;
+        return LL_STATUS_NO_ENOUGH_BYTES;
     }
 
-    if(message_opened)
+    *remainder = end_pos == byte_stream_size - 1 ? 0 : end_pos + 1;
+
+    size_t encoded_size = end_pos - begin_pos - 1;
+    if(encoded_size > encoded_max)
     {
-        *remainder = byte_stream_size - message_iter - 1;
-        return LL_STATUS_NO_ENOUGH_BYTES;
+        return LL_STATUS_MESSAGE_TOO_LONG;
     }
+    ll_status_t status = ll_cobs_decode(msg_info, stream, begin_pos + 1, end_pos, out);
+    if(status != LL_STATUS_SUCCESS && *remainder == 0)
+    {
+        *remainder = byte_stream_size;
+    }
+    return status;
+}
 
-    *remainder = byte_stream_size;
-    return LL_STATUS_NO_MESSAGE;
+
+static ll_status_t ll_xor_decode(ll_message_info_t msg_info,
+                                 const ll_stream_t* stream,
+                                 size_t begin,
+                                 size_t end,
+                                 ll_frame_out_t* out)
+{
+    size_t message_iter = 0;
+    //"reject byte" was the last byte of previous span
+    bool escaped = false;
+
+    while(begin < end)
+    {
+        size_t encoded_size;
+        const uint8_t* encoded = ll_stream_at(stream, begin, &encoded_size);
+        if(encoded_size > end - begin)
+        {
+            encoded_size = end - begin;
+        }
+        begin += encoded_size;
+
+        size_t i = 0;
+        if(escaped)
+        {
+            if(message_iter == msg_info.size)
+            {
+                return LL_STATUS_MESSAGE_TOO_LONG;
+            }
+            ll_put_byte(out, message_iter++, encoded[0] ^ LL_XOR_MASK);
+            escaped = false;
+            i++;
+        }
+
+        while(i < encoded_size)
+        {
+            const uint8_t* found = memchr(encoded + i, msg_info.reject_byte, encoded_size - i);
+            size_t run = found ? (size_t)(found - (encoded + i)) : encoded_size - i;
+
+            if(run > msg_info.size - message_iter)
+            {
+                return LL_STATUS_MESSAGE_TOO_LONG;
+            }
+            ll_put_bytes(out, message_iter, encoded + i, run);
+            message_iter += run;
+            i += run;
+
+            if(found)
+            {
+                if(i + 1 == encoded_size)
+                {
+                    escaped = true;
+                    break;
+                }
+                if(message_iter == msg_info.size)
+                {
+                    return LL_STATUS_MESSAGE_TOO_LONG;
+                }
+                ll_put_byte(out, message_iter++, encoded[i + 1] ^ LL_XOR_MASK);
+                i += 2;
+            }
+        }
+    }
+
+    return !escaped && message_iter == msg_info.size ? LL_STATUS_SUCCESS : LL_STATUS_MESSAGE_TOO_SHORT;
+}
+
+static ll_status_t ll_xor_deserialize(ll_message_info_t msg_info,
+                                      const ll_stream_t* stream,
+                                      ll_frame_out_t* out,
+                                      size_t* remainder)
+{
+    size_t byte_stream_size = stream->size;
+    size_t begin_pos = ll_stream_find(stream, 0, byte_stream_size, msg_info.begin_byte, msg_info.begin_byte);
+    if(begin_pos == byte_stream_size)
+    {
+        *remainder = byte_stream_size;
+        return LL_STATUS_NO_MESSAGE;
+    }
+
+    out->begin = begin_pos;
+    //control bytes never appear inside of message, so the next of them closes it
+    size_t encoded_max = ll_sizeof_serialized_max(msg_info) - 2;
+    size_t close_pos = ll_stream_find(stream,
+                                      begin_pos + 1,
+                                      byte_stream_size,
+                                      msg_info.begin_byte,
+                                      msg_info.end_byte);
+    if(close_pos == byte_stream_size)
+    {
+        if(byte_stream_size - begin_pos - 1 > encoded_max)
+        {
+            *remainder = byte_stream_size;
+            return LL_STATUS_MESSAGE_TOO_LONG;
+        }
+        *remainder = begin_pos;
+        return LL_STATUS_NO_ENOUGH_BYTES;
+    }
+
+    if(ll_stream_byte(stream, close_pos) == msg_info.begin_byte)
+    {
+        *remainder = close_pos;
+        return close_pos - begin_pos - 1 > encoded_max ? LL_STATUS_MESSAGE_TOO_LONG
+                                                       : LL_STATUS_MESSAGE_TOO_SHORT;
+    }
+
+    *remainder = close_pos == byte_stream_size - 1 ? 0 : close_pos + 1;
+
+    size_t encoded_size = close_pos - begin_pos - 1;
+    ll_status_t status = encoded_size > encoded_max
+                         ? LL_STATUS_MESSAGE_TOO_LONG
+                         : ll_xor_decode(msg_info, stream, begin_pos + 1, close_pos, out);
+    if(status != LL_STATUS_SUCCESS && *remainder == 0)
+    {
+        *remainder = byte_stream_size;
+    }
+    return status;
+}
+
+
+static ll_status_t ll_reject_deserialize(ll_message_info_t msg_info,
+                                         const ll_stream_t* stream,
+                                         ll_frame_out_t* out,
+                                         size_t* remainder)
+{
+    *remainder = 0;
+    bool message_opened = false;
+    bool reject = false;
+    bool ignore_previous = false;
+    size_t message_iter = 0;
+    uint8_t byte = msg_info.end_byte;
+    uint8_t previous_byte = msg_info.end_byte;
+    size_t byte_stream_size = stream->size;
+    size_t i = 0;
+
+    for(size_t span = 0; span < stream->spans_count; span++)
+    {
+        const uint8_t* data = stream->spans[span].data;
+        for(size_t j = 0; j < stream->spans[span].size; j++, i++)
+        {
+            previous_byte = byte;
+            byte = data[j];
+
+            if(  !message_opened
+               && byte == msg_info.begin_byte
+               && previous_byte != msg_info.reject_byte)
+            {
+                message_opened = true;
+                out->begin = i;
+                //"begin byte" is not a byte of message (message of size 0 ends right after it)
+                continue;
+            }
+
+            if(!message_opened)
+            {
+                continue;
+            }
+
+            if(message_iter == msg_info.size)
+            {
+                message_opened = false;
+                if(byte == msg_info.end_byte)
+                {
+                    if(i == byte_stream_size - 1)
+                    {
+                        *remainder = 0;
+                    }
+                    else
+                    {
+                        *remainder = i + 1;
+                    }
+                    return LL_STATUS_SUCCESS;
+                }
+                else
+                {
+                    *remainder = i;
+                    return LL_STATUS_MESSAGE_TOO_LONG;
+                }
+                message_iter = 0;
+                continue;
+            }
+
+            if(   byte == msg_info.end_byte
+               && previous_byte != msg_info.reject_byte
+               && !ignore_previous
+               && message_iter < msg_info.size)
+            {
+                message_opened = false;
+                reject = false;
+                message_iter = 0;
+                *remainder = i + 1;
+                return LL_STATUS_MESSAGE_TOO_SHORT;
+            }
+
+            //it seems that it can be optimized
+            //by combining this "if()"
+            if(   (byte != msg_info.reject_byte
+               && byte != msg_info.begin_byte
+               && byte != msg_info.end_byte
+               && previous_byte != msg_info.reject_byte)
+               ||
+                 (byte != msg_info.reject_byte
+               && byte != msg_info.begin_byte
+               && byte != msg_info.end_byte
+               && ignore_previous))
+            {
+                ll_put_byte(out, message_iter++, byte);
+                ignore_previous = false;
+
+                //the next bytes which are not control bytes are put in the same way
+                size_t run = stream->spans[span].size - j - 1;
+                if(run > msg_info.size - message_iter)
+                {
+                    run = msg_info.size - message_iter;
+                }
+                run = ll_find_control(msg_info, data + j + 1, run);
+                if(run > 0)
+                {
+                    ll_put_bytes(out, message_iter, data + j + 1, run);
+                    message_iter += run;
+                    j += run;
+                    i += run;
+                    byte = data[j];
+                }
+                continue;
+             }
+
+            //with this "if()"
+            if(reject)
+            {
+                ll_put_byte(out, message_iter++, byte);
+                if(byte == msg_info.reject_byte)
+                {
+                    ignore_previous = true;
+                }
+                reject = false;
+                continue;
+            }
+
+            if(byte == msg_info.reject_byte && (previous_byte != msg_info.reject_byte || ignore_previous))
+            {
+                reject = true;
+                if(ignore_previous)
+                {
+                    ignore_previous = false;
+                }
+            }
+        }
+    }
+
+    if(message_opened)
+    {
+        //escaped bytes are not counted in "message_iter", so position of "begin byte" is taken
+        *remainder = out->begin;
+        return LL_STATUS_NO_ENOUGH_BYTES;
+    }
+
+    *remainder = byte_stream_size;
+    return LL_STATUS_NO_MESSAGE;
+}
+
+
+size_t ll_sizeof_serialized_max(ll_message_info_t msg_info)
+{
+    if(msg_info.checksum >= LL_CHECKSUM_ENUM_SIZE)
+    {
+        return 0;
+    }
+
+    size_t size = msg_info.size + ll_trailer_size(msg_info);
+    switch(msg_info.framing)
+    {
+    case LL_FRAMING_REJECT:
+    case LL_FRAMING_XOR:
+        return size * 2 + 2;
+    case LL_FRAMING_COBS:
+        if(size == 0)
+        {
+            return 3;
+        }
+        return size + 2 + (size + LL_COBS_BLOCK_MAX - 1) / LL_COBS_BLOCK_MAX;
+    default:
+        return 0;
+    }
+}
+
+size_t ll_sizeof_serialized(ll_message_info_t msg_info, const uint8_t* data)
+{
+    if(!data || !ll_message_info_valid(msg_info))
+    {
+        return 0;
+    }
+
+    uint8_t trailer[LL_CHECKSUM_SIZE];
+    size_t trailer_size = ll_trailer_size(msg_info);
+    if(trailer_size)
+    {
+        ll_store_checksum(trailer, ll_crc32c(0, data, msg_info.size));
+    }
+
+    if(msg_info.framing == LL_FRAMING_COBS)
+    {
+        ll_cobs_encoder_t encoder;
+        ll_cobs_begin(&encoder, NULL);
+        ll_cobs_feed(msg_info, &encoder, data, msg_info.size);
+        ll_cobs_feed(msg_info, &encoder, trailer, trailer_size);
+        ll_cobs_finish(msg_info, &encoder);
+        //+2 is for msg_info.begin_byte at the beginning and msg_info.end_byte at the end of message
+        return encoder.size + 2;
+    }
+
+    //+2 is for msg_info.begin_byte at the beginning and msg_info.end_byte at the end of message
+    return   ll_sizeof_escaped(msg_info, data, msg_info.size)
+           + ll_sizeof_escaped(msg_info, trailer, trailer_size)
+           + 2;
+}
+
+size_t ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* data_out)
+{
+    if(!data_in || !data_out || !ll_message_info_valid(msg_info))
+    {
+        return 0;
+    }
+
+    uint8_t* tmp_out = data_out;
+    uint32_t checksum = 0;
+    uint8_t trailer[LL_CHECKSUM_SIZE];
+    size_t trailer_size = ll_trailer_size(msg_info);
+    size_t chunk = trailer_size ? LL_CHECKSUM_CHUNK : msg_info.size;
+    ll_cobs_encoder_t encoder;
+
+    *data_out = msg_info.begin_byte;
+    tmp_out++;
+
+    if(msg_info.framing == LL_FRAMING_COBS)
+    {
+        ll_cobs_begin(&encoder, tmp_out);
+    }
+
+    for(size_t i = 0; i < msg_info.size; i += chunk)
+    {
+        size_t size = msg_info.size - i < chunk ? msg_info.size - i : chunk;
+        if(trailer_size)
+        {
+            checksum = ll_crc32c(checksum, data_in + i, size);
+        }
+        if(msg_info.framing == LL_FRAMING_COBS)
+        {
+            ll_cobs_feed(msg_info, &encoder, data_in + i, size);
+        }
+        else
+        {
+            tmp_out += ll_escape(msg_info, data_in + i, size, tmp_out);
+        }
+    }
+
+    if(trailer_size)
+    {
+        ll_store_checksum(trailer, checksum);
+    }
+    if(msg_info.framing == LL_FRAMING_COBS)
+    {
+        ll_cobs_feed(msg_info, &encoder, trailer, trailer_size);
+        ll_cobs_finish(msg_info, &encoder);
+        tmp_out = encoder.out;
+    }
+    else
+    {
+        tmp_out += ll_escape(msg_info, trailer, trailer_size, tmp_out);
+    }
+    *tmp_out = msg_info.end_byte;
+    return (size_t)(tmp_out - data_out) + 1;
+}
+
+//if "data_out" is NULL message is only scanned and "scan" is filled,
+//if "filter" is not NULL only matched message is written to "data_out" (see ll_deserialize_filtered)
+static ll_status_t ll_deserialize_stream(ll_message_info_t msg_info,
+                                         const ll_stream_t* stream,
+                                         uint8_t* data_out,
+                                         ll_frame_scan_t* scan,
+                                         const ll_filter_t* filter,
+                                         bool* matched,
+                                         size_t* remainder)
+{
+    //checksum is parsed as the last bytes of message
+    ll_frame_out_t out;
+    out.data = data_out;
+    out.data_size = msg_info.size;
+    out.begin = 0;
+    out.count = 0;
+    out.filter = filter;
+    out.filter_size = filter && filter->predicate ? filter->header_size : 1;
+    out.matched = true;
+    out.use_checksum = msg_info.checksum == LL_CHECKSUM_CRC32C;
+    out.checksum = 0;
+    out.checked = 0;
+    out.staged = 0;
+    ll_message_info_t frame_info = msg_info;
+    frame_info.size += ll_trailer_size(msg_info);
+    frame_info.checksum = LL_CHECKSUM_NONE;
+
+    ll_status_t status;
+    switch(msg_info.framing)
+    {
+    case LL_FRAMING_COBS:
+        status = ll_cobs_deserialize(frame_info, stream, &out, remainder);
+        break;
+    case LL_FRAMING_XOR:
+        status = ll_xor_deserialize(frame_info, stream, &out, remainder);
+        break;
+    default:
+        status = ll_reject_deserialize(frame_info, stream, &out, remainder);
+        break;
+    }
+
+    if(scan)
+    {
+        scan->begin = out.begin;
+        scan->size = out.count;
+    }
+    if(matched)
+    {
+        //message which is shorter than header is not matched
+        *matched = out.matched && !out.filter;
+    }
+    if(status == LL_STATUS_SUCCESS && msg_info.checksum == LL_CHECKSUM_CRC32C)
+    {
+        uint32_t checksum;
+        if(out.data)
+        {
+            //only the last bytes which were not enough for chunk are read here
+            checksum = ll_crc32c(out.checksum, data_out + out.checked, msg_info.size - out.checked);
+        }
+        else
+        {
+            ll_scan_flush(&out);
+            checksum = out.checksum;
+        }
+        if(checksum != ll_load_checksum(out.trailer))
+        {
+            return LL_STATUS_CHECKSUM_FAILURE;
+        }
+    }
+    return status;
+}
+
+ll_status_t ll_deserialize(ll_message_info_t msg_info,
+                           const uint8_t* byte_stream,
+                           size_t byte_stream_size,
+                           uint8_t* data_out,
+                           size_t* remainder)
+{
+    if(!byte_stream || !data_out || !remainder || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_span_t span = { byte_stream, byte_stream_size };
+    ll_stream_t stream = { &span, 1, byte_stream_size };
+    return ll_deserialize_stream(msg_info, &stream, data_out, NULL, NULL, NULL, remainder);
+}
+
+ll_status_t ll_scan(ll_message_info_t msg_info,
+                    const uint8_t* byte_stream,
+                    size_t byte_stream_size,
+                    ll_frame_scan_t* frame,
+                    size_t* remainder)
+{
+    if(!byte_stream || !frame || !remainder || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_span_t span = { byte_stream, byte_stream_size };
+    ll_stream_t stream = { &span, 1, byte_stream_size };
+    return ll_deserialize_stream(msg_info, &stream, NULL, frame, NULL, NULL, remainder);
+}
+
+ll_status_t ll_deserialize_filtered(ll_message_info_t msg_info,
+                                    const ll_filter_t* filter,
+                                    const uint8_t* byte_stream,
+                                    size_t byte_stream_size,
+                                    uint8_t* data_out,
+                                    bool* matched,
+                                    size_t* remainder)
+{
+    if(   !filter || !byte_stream || !data_out || !matched || !remainder
+       || !ll_message_info_valid(msg_info)
+       || (filter->predicate && (filter->header_size == 0 || filter->header_size > msg_info.size))
+       || (!filter->predicate && msg_info.size == 0))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_span_t span = { byte_stream, byte_stream_size };
+    ll_stream_t stream = { &span, 1, byte_stream_size };
+    return ll_deserialize_stream(msg_info, &stream, data_out, NULL, filter, matched, remainder);
+}
+
+void ll_filter_add_first_byte(ll_filter_t* filter, uint8_t byte)
+{
+    if(filter)
+    {
+        filter->first_bytes[byte >> 3] |= (uint8_t)(1u << (byte & 7));
+    }
+}
+
+ll_status_t ll_deserialize_spans(ll_message_info_t msg_info,
+                                 const ll_span_t* spans,
+                                 size_t spans_count,
+                                 uint8_t* data_out,
+                                 size_t* remainder)
+{
+    if(!spans || !data_out || !remainder || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_stream_t stream = { spans, spans_count, 0 };
+    for(size_t i = 0; i < spans_count; i++)
+    {
+        if(!spans[i].data && spans[i].size)
+        {
+            return LL_STATUS_BAD_PARAMS;
+        }
+        stream.size += spans[i].size;
+    }
+    return ll_deserialize_stream(msg_info, &stream, data_out, NULL, NULL, NULL, remainder);
+}
+
+ll_status_t ll_decoder_init(ll_decoder_t* decoder, ll_message_info_t msg_info, uint8_t* buffer)
+{
+    if(!decoder || !buffer || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    decoder->msg_info = msg_info;
+    decoder->buffer = buffer;
+    decoder->message_iter = 0;
+    decoder->checksum = 0;
+    memset(decoder->trailer, 0, sizeof(decoder->trailer));
+    decoder->state = LL_DECODER_IDLE;
+    decoder->cobs_run = 0;
+    decoder->cobs_delimiter = false;
+    decoder->status = LL_STATUS_NO_MESSAGE;
+    decoder->tracker = NULL;
+    return LL_STATUS_SUCCESS;
+}
+
+static inline size_t ll_decoder_frame_size(const ll_decoder_t* decoder)
+{
+    return decoder->msg_info.size + ll_trailer_size(decoder->msg_info);
+}
+
+//ends message with error status
+static void ll_decoder_fail(ll_decoder_t* decoder, ll_status_t status)
+{
+    decoder->status = status;
+    if(decoder->tracker)
+    {
+        ll_latency_end(decoder->tracker, false);
+    }
+}
+
+static void ll_decoder_open(ll_decoder_t* decoder)
+{
+    if(decoder->tracker)
+    {
+        //message which was not ended before the next "begin byte" is lost
+        ll_latency_end(decoder->tracker, false);
+        ll_latency_begin(decoder->tracker);
+    }
+    decoder->message_iter = 0;
+    decoder->checksum = 0;
+    decoder->state = decoder->msg_info.framing == LL_FRAMING_COBS ? LL_DECODER_COBS_CODE
+                                                                   : LL_DECODER_DATA;
+}
+
+//returns false if message is already full
+static inline bool ll_decoder_put(ll_decoder_t* decoder, uint8_t byte)
+{
+    size_t size = decoder->msg_info.size;
+    size_t message_iter = decoder->message_iter;
+    if(message_iter < size)
+    {
+        decoder->buffer[message_iter] = byte;
+        if(decoder->msg_info.checksum == LL_CHECKSUM_CRC32C)
+        {
+            decoder->checksum = ll_crc32c(decoder->checksum, &byte, 1);
+        }
+    }
+    else if(message_iter < ll_decoder_frame_size(decoder))
+    {
+        decoder->trailer[message_iter - size] = byte;
+    }
+    else
+    {
+        return false;
+    }
+    decoder->message_iter++;
+    return true;
+}
+
+//called when "end byte" closes message, returns true if message was parsed
+static bool ll_decoder_close(ll_decoder_t* decoder)
+{
+    if(decoder->message_iter != ll_decoder_frame_size(decoder))
+    {
+        ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_SHORT);
+        return false;
+    }
+    if(   decoder->msg_info.checksum == LL_CHECKSUM_CRC32C
+       && decoder->checksum != ll_load_checksum(decoder->trailer))
+    {
+        ll_decoder_fail(decoder, LL_STATUS_CHECKSUM_FAILURE);
+        return false;
+    }
+    decoder->status = LL_STATUS_SUCCESS;
+    if(decoder->tracker)
+    {
+        ll_latency_end(decoder->tracker, true);
+    }
+    return true;
+}
+
+static bool ll_decoder_push_cobs(ll_decoder_t* decoder, uint8_t byte)
+{
+    ll_message_info_t msg_info = decoder->msg_info;
+
+    if(byte == msg_info.end_byte)
+    {
+        bool parsed = false;
+        if(decoder->state == LL_DECODER_COBS_CODE)
+        {
+            parsed = ll_decoder_close(decoder);
+        }
+        else if(decoder->state == LL_DECODER_COBS_BLOCK)
+        {
+            ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_SHORT);
+        }
+        decoder->state = LL_DECODER_IDLE;
+        return parsed;
+    }
+
+    switch(decoder->state)
+    {
+    case LL_DECODER_COBS_CODE:
+        //implied "end byte" of previous block is known to be data only when the next block starts
+        if(decoder->cobs_delimiter && !ll_decoder_put(decoder, msg_info.end_byte))
+        {
+            break;
+        }
+        decoder->cobs_run = (uint8_t)((byte ^ msg_info.end_byte) - 1);
+        decoder->cobs_delimiter = decoder->cobs_run != LL_COBS_BLOCK_MAX;
+        decoder->state = decoder->cobs_run ? LL_DECODER_COBS_BLOCK : LL_DECODER_COBS_CODE;
+        return false;
+    case LL_DECODER_COBS_BLOCK:
+        if(!ll_decoder_put(decoder, byte))
+        {
+            break;
+        }
+        if(--decoder->cobs_run == 0)
+        {
+            decoder->state = LL_DECODER_COBS_CODE;
+        }
+        return false;
+    case LL_DECODER_COBS_SKIP:
+        return false;
+    default:
+        if(byte == msg_info.begin_byte)
+        {
+            decoder->cobs_delimiter = false;
+            ll_decoder_open(decoder);
+        }
+        return false;
+    }
+
+    ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_LONG);
+    decoder->state = LL_DECODER_COBS_SKIP;
+    return false;
+}
+
+bool ll_decoder_push_byte(ll_decoder_t* decoder, uint8_t byte)
+{
+    if(!decoder || !decoder->buffer)
+    {
+        return false;
+    }
+
+    ll_message_info_t msg_info = decoder->msg_info;
+    if(msg_info.framing == LL_FRAMING_COBS)
+    {
+        return ll_decoder_push_cobs(decoder, byte);
+    }
+
+    switch(decoder->state)
+    {
+    case LL_DECODER_DATA:
+        if(decoder->message_iter == ll_decoder_frame_size(decoder))
+        {
+            if(byte == msg_info.end_byte)
+            {
+                decoder->state = LL_DECODER_IDLE;
+                return ll_decoder_close(decoder);
+            }
+            //byte is parsed again as the first byte after message
+            ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_LONG);
+            break;
+        }
+        if(byte == msg_info.reject_byte)
+        {
+            decoder->state = LL_DECODER_ESCAPED;
+            return false;
+        }
+        if(byte == msg_info.end_byte || byte == msg_info.begin_byte)
+        {
+            ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_SHORT);
+            break;
+        }
+        ll_decoder_put(decoder, byte);
+        return false;
+    case LL_DECODER_ESCAPED:
+        if(msg_info.framing == LL_FRAMING_XOR)
+        {
+            //in LL_FRAMING_XOR mode control bytes are never escaped
+            if(byte == msg_info.end_byte || byte == msg_info.begin_byte)
+            {
+                ll_decoder_fail(decoder, LL_STATUS_MESSAGE_TOO_SHORT);
+                break;
+            }
+            byte ^= LL_XOR_MASK;
+        }
+        ll_decoder_put(decoder, byte);
+        decoder->state = LL_DECODER_DATA;
+        return false;
+    default:
+        break;
+    }
+
+    if(byte == msg_info.begin_byte && decoder->state != LL_DECODER_IDLE_REJECTED)
+    {
+        ll_decoder_open(decoder);
+    }
+    else if(msg_info.framing == LL_FRAMING_REJECT && byte == msg_info.reject_byte)
+    {
+        decoder->state = LL_DECODER_IDLE_REJECTED;
+    }
+    else
+    {
+        decoder->state = LL_DECODER_IDLE;
+    }
+    return false;
+}
+
+
+//copies run of message bytes which can't change state of decoder, returns its size
+static size_t ll_decoder_copy_run(ll_decoder_t* decoder, const uint8_t* data, size_t size)
+{
+    ll_message_info_t msg_info = decoder->msg_info;
+    size_t room = decoder->message_iter < msg_info.size ? msg_info.size - decoder->message_iter : 0;
+    if(room > size)
+    {
+        room = size;
+    }
+
+    size_t run;
+    if(decoder->state == LL_DECODER_COBS_BLOCK)
+    {
+        if(room > decoder->cobs_run)
+        {
+            room = decoder->cobs_run;
+        }
+        const uint8_t* found = memchr(data, msg_info.end_byte, room);
+        run = found ? (size_t)(found - data) : room;
+        decoder->cobs_run -= (uint8_t)run;
+        if(decoder->cobs_run == 0)
+        {
+            decoder->state = LL_DECODER_COBS_CODE;
+        }
+    }
+    else if(decoder->state == LL_DECODER_DATA && msg_info.framing != LL_FRAMING_COBS)
+    {
+        run = ll_find_control(msg_info, data, room);
+    }
+    else
+    {
+        return 0;
+    }
+
+    memcpy(decoder->buffer + decoder->message_iter, data, run);
+    if(msg_info.checksum == LL_CHECKSUM_CRC32C)
+    {
+        decoder->checksum = ll_crc32c(decoder->checksum, data, run);
+    }
+    decoder->message_iter += run;
+    return run;
+}
+
+bool ll_decoder_push(ll_decoder_t* decoder, const uint8_t* data, size_t size, size_t* consumed)
+{
+    if(!decoder || !data || !consumed)
+    {
+        return false;
+    }
+
+    size_t i = 0;
+    while(i < size)
+    {
+        i += ll_decoder_copy_run(decoder, data + i, size - i);
+        if(i == size)
+        {
+            break;
+        }
+        if(ll_decoder_push_byte(decoder, data[i++]))
+        {
+            *consumed = i;
+            return true;
+        }
+    }
+    *consumed = size;
+    return false;
+}
+
+ll_status_t ll_encoder_init(ll_encoder_t* encoder, ll_message_info_t msg_info, const uint8_t* data)
+{
+    if(!encoder || !data || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    encoder->msg_info = msg_info;
+    encoder->data = data;
+    encoder->message_iter = 0;
+    encoder->checksum_iter = 0;
+    encoder->checksum = 0;
+    ll_store_checksum(encoder->trailer, 0);
+    encoder->state = LL_ENCODER_BEGIN;
+    encoder->pending = 0;
+    encoder->cobs_run = 0;
+    encoder->cobs_delimiter = false;
+    return LL_STATUS_SUCCESS;
+}
+
+static inline size_t ll_encoder_frame_size(const ll_encoder_t* encoder)
+{
+    return encoder->msg_info.size + ll_trailer_size(encoder->msg_info);
+}
+
+//returns byte of message or checksum, bytes are always read in order for the first time
+//(COBS looks ahead), so checksum is calculated before its bytes are read
+static uint8_t ll_encoder_byte(ll_encoder_t* encoder, size_t message_iter)
+{
+    size_t size = encoder->msg_info.size;
+    if(message_iter >= size)
+    {
+        return encoder->trailer[message_iter - size];
+    }
+
+    uint8_t byte = encoder->data[message_iter];
+    if(   encoder->msg_info.checksum == LL_CHECKSUM_CRC32C
+       && message_iter == encoder->checksum_iter)
+    {
+        encoder->checksum = ll_crc32c(encoder->checksum, &byte, 1);
+        if(++encoder->checksum_iter == size)
+        {
+            ll_store_checksum(encoder->trailer, encoder->checksum);
+        }
+    }
+    return byte;
+}
+
+//chooses what is after COBS block
+static void ll_encoder_cobs_next(ll_encoder_t* encoder)
+{
+    if(encoder->cobs_delimiter)
+    {
+        //implied "end byte" is not sent
+        encoder->message_iter++;
+        encoder->state = LL_ENCODER_COBS_CODE;
+    }
+    else if(encoder->message_iter < ll_encoder_frame_size(encoder))
+    {
+        //block of maximal length
+        encoder->state = LL_ENCODER_COBS_CODE;
+    }
+    else
+    {
+        encoder->state = LL_ENCODER_END;
+    }
+}
+
+static uint8_t ll_encoder_cobs_code(ll_encoder_t* encoder)
+{
+    size_t frame_size = ll_encoder_frame_size(encoder);
+    size_t message_iter = encoder->message_iter;
+    uint8_t end_byte = encoder->msg_info.end_byte;
+    size_t run = 0;
+
+    while(   run < LL_COBS_BLOCK_MAX
+          && message_iter + run < frame_size
+          && ll_encoder_byte(encoder, message_iter + run) != end_byte)
+    {
+        run++;
+    }
+
+    encoder->cobs_run = (uint8_t)run;
+    encoder->cobs_delimiter = run < LL_COBS_BLOCK_MAX && message_iter + run < frame_size;
+    if(run)
+    {
+        encoder->state = LL_ENCODER_COBS_BLOCK;
+    }
+    else
+    {
+        ll_encoder_cobs_next(encoder);
+    }
+    return (uint8_t)((run + 1) ^ end_byte);
+}
+
+bool ll_encoder_next_byte(ll_encoder_t* encoder, uint8_t* byte)
+{
+    if(!encoder || !byte || !encoder->data)
+    {
+        return false;
+    }
+
+    ll_message_info_t msg_info = encoder->msg_info;
+    switch(encoder->state)
+    {
+    case LL_ENCODER_BEGIN:
+        *byte = msg_info.begin_byte;
+        encoder->state = msg_info.framing == LL_FRAMING_COBS ? LL_ENCODER_COBS_CODE
+                                                              : LL_ENCODER_DATA;
+        return true;
+    case LL_ENCODER_DATA:
+        if(encoder->message_iter == ll_encoder_frame_size(encoder))
+        {
+            *byte = msg_info.end_byte;
+            encoder->state = LL_ENCODER_DONE;
+            return true;
+        }
+        *byte = ll_encoder_byte(encoder, encoder->message_iter++);
+        if(ll_is_control_byte(msg_info, *byte))
+        {
+            encoder->pending = msg_info.framing == LL_FRAMING_XOR ? *byte ^ LL_XOR_MASK : *byte;
+            encoder->state = LL_ENCODER_ESCAPED;
+            *byte = msg_info.reject_byte;
+        }
+        return true;
+    case LL_ENCODER_ESCAPED:
+        *byte = encoder->pending;
+        encoder->state = LL_ENCODER_DATA;
+        return true;
+    case LL_ENCODER_COBS_CODE:
+        *byte = ll_encoder_cobs_code(encoder);
+        return true;
+    case LL_ENCODER_COBS_BLOCK:
+        *byte = ll_encoder_byte(encoder, encoder->message_iter++);
+        if(--encoder->cobs_run == 0)
+        {
+            ll_encoder_cobs_next(encoder);
+        }
+        return true;
+    case LL_ENCODER_END:
+        *byte = msg_info.end_byte;
+        encoder->state = LL_ENCODER_DONE;
+        return true;
+    default:
+        return false;
+    }
 }
@@ -101,6 +101,59 @@ Error for too long message will be detected and we will lose second message beca
 start byte of second message will be interpreted as byte that must be rejected.
 
 
+COBS FRAMING MODE.
+    Byte stuffing described above can double the size of message (examples 4.2, 4.3, 4.4).
+If you need predictable worst case you can set "framing" field of message info to
+LL_FRAMING_COBS. In this mode message is encoded with Consistent Overhead Byte Stuffing
+and "reject byte" is not used.
+
+    Message is split into blocks by bytes which values are equal to "end byte". Every
+block is written as a "code byte" followed by bytes of block. "code byte" is equal to
+(block length + 1) XOR "end byte", so "end byte" never appears inside of serialized
+message. Block can't be longer than 254 bytes, longer sequences are split without
+implied "end byte" between them. "begin byte" is added at the beginning and "end byte"
+at the end of message, as in default mode.
+
+    Redundancy is 2 bytes plus one "code byte" per each started 254 bytes of message (at
+least one), 3 bytes for message size 16, no matter how many bytes of message are equal to control bytes.
+
+Example (for message size 16 bytes, "begin byte" 0xAA, "end byte" 0xBB):
+   input:  F3 BB AA C4 95 CC 76 8B 12 CC 34 DD AA 77 51 BB
+   output: AA B9 F3 B5 AA C4 95 CC 76 8B 12 CC 34 DD AA 77 51 BA BB
+   bytes stream 19 bytes, redundancy 3 bytes
+
+    Since "end byte" can appear only at the end of message, distortion can't make
+deserializer lose next message as described in WARNING above. Bytes between "begin byte"
+and next "end byte" are always treated as one message.
+
+
+XOR FRAMING MODE.
+    In default mode byte after "reject byte" keeps its value, so pair "reject byte" + control
+byte looks like control byte and deserializer has to look at previous bytes to understand
+what it is (see WARNING above). If you set "framing" field of message info to LL_FRAMING_XOR,
+bytes of message equal to control bytes are written as "reject byte" followed by the byte
+XORed with 0x20, like in async HDLC and PPP. Control bytes never appear inside of
+serialized message, so "begin byte" and "end byte" always mean begin and end of message.
+
+    In this mode control bytes XORed with 0x20 must not be equal to any control byte,
+otherwise functions do nothing (serializing) or return LL_STATUS_BAD_PARAMS (deserializing).
+
+Example (for message size 16 bytes, "begin byte" 0xAA, "end byte" 0xBB
+and "reject byte" 0xCC):
+   input:  F3 BB AA C4 95 CC 76 8B 12 CC 34 DD AA 77 51 BB
+   output: AA F3 CC 9B CC 8A C4 95 CC EC 76 8B 12 CC EC 34 DD CC 8A 77 51 CC 9B BB
+   bytes stream 24 bytes, redundancy 8 bytes, the same as in example 4.1
+
+
+CHECKSUM.
+    If you set "checksum" field of message info to LL_CHECKSUM_CRC32C, serializer calculates
+CRC32C of message while escaping it and adds 4 bytes of checksum (little endian) after the
+last byte of message, before "end byte". Checksum bytes are escaped in the same way as bytes
+of message in any framing mode. Deserializer calculates checksum while unescaping (parsed
+bytes are added to it by chunks while they are still in L1 cache, so message is not read
+again after parsing) and returns LL_STATUS_CHECKSUM_FAILURE if it doesn't match. Checksum is not written to "data_out".
+
+
 Example for code use:
 @todo
 
@@ -127,17 +180,103 @@ typedef enum
     LL_STATUS_MESSAGE_TOO_SHORT, //message has started with "begin byte" but has ended too early with "end byte"
     LL_STATUS_MESSAGE_TOO_LONG,  /*message started with "begin byte" but hasn't end with "end byte" after last 
                                    byte of message came*/
+    LL_STATUS_CHECKSUM_FAILURE,  //message was parsed but its checksum doesn't match
+    LL_STATUS_NO_REFERENCE,      //delta was parsed but there is no previous message for it (see ll_delta.h)
     LL_STATUS_ENUM_SIZE          //enum size
 } ll_status_t;
 
+typedef enum
+{
+    LL_FRAMING_REJECT,   //"reject byte" is added before bytes equal to control bytes (default)
+    LL_FRAMING_COBS,     //consistent overhead byte stuffing, see "COBS FRAMING MODE" above
+    LL_FRAMING_XOR,      //escaped bytes are XORed with 0x20, see "XOR FRAMING MODE" above
+    LL_FRAMING_ENUM_SIZE //enum size
+} ll_framing_t;
+
+typedef enum
+{
+    LL_CHECKSUM_NONE,     //no checksum (default)
+    LL_CHECKSUM_CRC32C,   //CRC32C is added after message, see "CHECKSUM" above
+    LL_CHECKSUM_ENUM_SIZE //enum size
+} ll_checksum_t;
+
 typedef struct
 {
-    size_t  size;        //message size
-    uint8_t begin_byte;  //begin byte
-    uint8_t reject_byte; //reject byte
-    uint8_t end_byte;    //end byte
+    size_t  size;           //message size
+    uint8_t begin_byte;     //begin byte
+    uint8_t reject_byte;    //reject byte
+    uint8_t end_byte;       //end byte
+    ll_framing_t framing;   //framing mode, zero initialized struct means LL_FRAMING_REJECT
+    ll_checksum_t checksum; //checksum, zero initialized struct means LL_CHECKSUM_NONE
 } ll_message_info_t;
 
+//contiguous part of byte stream
+typedef struct
+{
+    const uint8_t* data;
+    size_t         size;
+} ll_span_t;
+
+//frame found by ll_scan
+typedef struct
+{
+    size_t begin; //position of "begin byte" of frame
+    size_t size;  //quantity of unescaped bytes of frame (message and checksum)
+} ll_frame_scan_t;
+
+/**
+ * @brief Predicate which is called by ll_deserialize_filtered for first bytes of every message.
+ * @param context context from ll_filter_t
+ * @param header first "header_size" bytes of message
+ * @param header_size header size from ll_filter_t
+ * @returns true if message is needed
+ */
+typedef bool (*ll_header_predicate_t)(void* context, const uint8_t* header, size_t header_size);
+
+//filter of messages for ll_deserialize_filtered, zero initialized struct doesn't match anything
+typedef struct
+{
+    uint8_t               first_bytes[32]; //set of accepted first bytes (bit "byte % 8" of byte "byte / 8"),
+                                           //it is used if predicate == NULL
+    ll_header_predicate_t predicate;       //predicate for first "header_size" bytes, can be NULL
+    size_t                header_size;     //quantity of bytes passed to predicate
+    void*                 context;         //context passed to predicate
+} ll_filter_t;
+
+//latency tracker, it is defined in ll_latency.h
+struct ll_latency_tracker_s;
+
+//state of decoder, it must be changed only by ll_decoder_* functions (except of tracker)
+typedef struct
+{
+    ll_message_info_t msg_info;
+    uint8_t*          buffer;
+    size_t            message_iter;
+    uint32_t          checksum;
+    uint8_t           trailer[4];     //received checksum
+    uint8_t           state;
+    uint8_t           cobs_run;       //bytes remaining in COBS block
+    bool              cobs_delimiter; //COBS block is followed by implied "end byte"
+    ll_status_t       status;         //status of the last ended message
+    struct ll_latency_tracker_s* tracker; //tracker of latency of messages, NULL by default,
+                                          //it can be set after ll_decoder_init
+} ll_decoder_t;
+
+//state of encoder, it must be changed only by ll_encoder_* functions
+typedef struct
+{
+    ll_message_info_t msg_info;
+    const uint8_t*    data;
+    size_t            message_iter;
+    size_t            checksum_iter;  //quantity of bytes added to checksum
+    uint32_t          checksum;
+    uint8_t           trailer[4];     //calculated checksum
+    uint8_t           state;
+    uint8_t           pending;        //escaped byte which follows "reject byte"
+    uint8_t           cobs_run;       //bytes remaining in COBS block
+    bool              cobs_delimiter; //COBS block is followed by implied "end byte"
+} ll_encoder_t;
+
 
 /**
  * @brief This function is used to know how many bytes you need
@@ -149,6 +288,24 @@ typedef struct
  */
 size_t ll_sizeof_serialized(ll_message_info_t msg_info, const uint8_t* data);
 
+/**
+ * @brief This function checks that message info can be used for serializing and deserializing.
+ * @param msg_info message info
+ * @returns false if "framing" or "checksum" is unknown or control bytes can't be used
+ * in LL_FRAMING_XOR mode (see "XOR FRAMING MODE" above), true otherwise
+ */
+bool ll_message_info_valid(ll_message_info_t msg_info);
+
+/**
+ * @brief This function is used to know how many bytes you need to reserve for
+ * serialized data of any message with given message info.
+ * @param msg_info message info
+ * @returns size*2+2 for LL_FRAMING_REJECT and LL_FRAMING_XOR, size+2+max(1, (size+253)/254)
+ * for LL_FRAMING_COBS and 0 for unknown framing, where size is message size + 4 with
+ * LL_CHECKSUM_CRC32C
+ */
+size_t ll_sizeof_serialized_max(ll_message_info_t msg_info);
+
 /**
  * @brief This function serializes "data_in" and puts the result to "data_out".
  *
@@ -157,8 +314,38 @@ size_t ll_sizeof_serialized(ll_message_info_t msg_info, const uint8_t* data);
  * if data_in == NULL then function does nothing
  * @param data_out area of memory with size that was returned by ll_sizeof_serialized,
  * if data_out == NULL then function does nothing
+ * @returns quantity of bytes putted to "data_out" (the same as ll_sizeof_serialized returns),
+ * 0 if function did nothing
+ */
+size_t ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* data_out);
+
+/**
+ * @brief This function is used to know how many bytes you need to reserve for
+ * escaped part of message (see ll_escape).
+ * @param msg_info message info
+ * @param data area of memory with size of "size" which will be parsed
+ * @param size size of part of message
+ * @returns quantity of bytes which must be reserved for "data_out" in "ll_escape",
+ * if data == NULL or framing is LL_FRAMING_COBS then function does nothing and returns 0
+ */
+size_t ll_sizeof_escaped(ll_message_info_t msg_info, const uint8_t* data, size_t size);
+
+/**
+ * @brief This function escapes part of message without adding "begin byte" and "end byte".
+ * It can be used to serialize message by parts: serialized message is "begin byte",
+ * escaped message, escaped checksum (if it is used) and "end byte". Parts can be escaped
+ * independently because in LL_FRAMING_REJECT and LL_FRAMING_XOR modes every byte is
+ * escaped without looking at other bytes. For LL_FRAMING_COBS function does nothing.
+ *
+ * @param msg_info message info
+ * @param data_in area of memory with size of "size" which will be escaped,
+ * if data_in == NULL then function does nothing
+ * @param size size of part of message
+ * @param data_out area of memory with size that was returned by ll_sizeof_escaped,
+ * if data_out == NULL then function does nothing
+ * @returns quantity of bytes written to "data_out"
  */
-void ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* data_out);
+size_t ll_escape(ll_message_info_t msg_info, const uint8_t* data_in, size_t size, uint8_t* data_out);
 
 /**
  * @brief This function parses bytes stream and puts the result to "data_out". When 
@@ -199,6 +386,18 @@ void ll_serialize(ll_message_info_t msg_info, const uint8_t* data_in, uint8_t* d
  * sequences which are not started with "begin byte". That means that there will not be any
  * information about these lost bytes.
  * 
+ * @note In LL_FRAMING_COBS mode message always lasts till the next "end byte". In cases 2 and 3
+ * function returns position of next byte after that "end byte", case 3 is also reported when
+ * there is no "end byte" in byte stream but message can't fit into remaining bytes anyway.
+ * @note In LL_FRAMING_XOR mode "begin byte" inside of message means that the end of message
+ * was lost. Function returns LL_STATUS_MESSAGE_TOO_SHORT and position of that "begin byte".
+ * In case 3 function returns position of next byte after "end byte" which closes too long
+ * message (or position of next "begin byte" if it comes first).
+ * @note With LL_CHECKSUM_CRC32C there is one more case. Message was parsed but checksum
+ * doesn't match. Behaviour: function writes "remainder" as in cases 5 and 6 and returns
+ * LL_STATUS_CHECKSUM_FAILURE.
+ * If "framing" or "checksum" is unknown function does nothing and returns LL_STATUS_BAD_PARAMS.
+ * 
  * @todo Catch information about lost bytes.
  * @todo Rewrite logic to make it closer to repetitive calling of this function.
  *
@@ -220,6 +419,177 @@ ll_status_t ll_deserialize(
     size_t* remainder
 );
 
+/**
+ * @brief This function does the same as ll_deserialize for byte stream which consists
+ * of several spans (for example circular DMA buffer, which gives two spans when write
+ * pointer wraps). Spans are parsed as one byte stream, message and escaped bytes can
+ * continue from one span to another, and spans are not copied.
+ *
+ * @param msg_info message info
+ * @param spans array of spans with size of spans_count, spans can be empty,
+ * if spans == NULL or data of not empty span is NULL then function does nothing
+ * and returns LL_STATUS_BAD_PARAMS
+ * @param spans_count quantity of spans
+ * @param data_out the same as in ll_deserialize
+ * @param remainder the same as in ll_deserialize, position is counted from
+ * the beginning of the first span as if spans were one byte stream
+ * @returns the same as ll_deserialize
+ */
+ll_status_t ll_deserialize_spans(
+    ll_message_info_t msg_info,
+    const ll_span_t* spans,
+    size_t spans_count,
+    uint8_t* data_out,
+    size_t* remainder
+);
+
+/**
+ * @brief This function does the same as ll_deserialize, but message is not written anywhere:
+ * it only finds the next frame and validates it (framing, size and checksum). It is faster
+ * than ll_deserialize when only positions and statuses of frames are needed (for example
+ * to count or index frames), because unescaped bytes are not copied.
+ *
+ * @param msg_info message info
+ * @param byte_stream the same as in ll_deserialize
+ * @param byte_stream_size byte stream size
+ * @param frame position of "begin byte" and quantity of unescaped bytes of found frame
+ * will be putted here, they are valid only if status is not LL_STATUS_NO_MESSAGE and
+ * not LL_STATUS_NO_ENOUGH_BYTES,
+ * if frame == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param remainder the same as in ll_deserialize
+ * @returns the same as ll_deserialize
+ */
+ll_status_t ll_scan(
+    ll_message_info_t msg_info,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    ll_frame_scan_t* frame,
+    size_t* remainder
+);
+
+/**
+ * @brief This function adds byte to set of accepted first bytes of filter.
+ * @param filter filter,
+ * if filter == NULL then function does nothing
+ * @param byte first byte of needed messages
+ */
+void ll_filter_add_first_byte(ll_filter_t* filter, uint8_t byte);
+
+/**
+ * @brief This function does the same as ll_deserialize, but message is written to "data_out"
+ * only if it is needed. Only first bytes of message are unescaped to check them by filter
+ * (one byte for set of first bytes, "header_size" bytes for predicate), the rest of message
+ * which is not needed is validated as in ll_scan without writing.
+ *
+ * @param msg_info message info
+ * @param filter filter of messages,
+ * if filter == NULL or filter->predicate != NULL and filter->header_size is 0 or bigger
+ * than msg_info.size or filter->predicate == NULL and msg_info.size is 0 (there is no
+ * first byte) then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param byte_stream the same as in ll_deserialize
+ * @param byte_stream_size byte stream size
+ * @param data_out the same as in ll_deserialize, if message is not matched only its first
+ * bytes are putted here
+ * @param matched true will be putted here if message was checked by filter and matched,
+ * if matched == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param remainder the same as in ll_deserialize
+ * @returns the same as ll_deserialize, status of not matched message is also reported
+ */
+ll_status_t ll_deserialize_filtered(
+    ll_message_info_t msg_info,
+    const ll_filter_t* filter,
+    const uint8_t* byte_stream,
+    size_t byte_stream_size,
+    uint8_t* data_out,
+    bool* matched,
+    size_t* remainder
+);
+
+/**
+ * @brief This function initializes decoder which parses byte stream byte by byte
+ * (see ll_decoder_push_byte).
+ *
+ * @param decoder decoder,
+ * if decoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info,
+ * if it is not valid (see ll_message_info_valid) then function does nothing and
+ * returns LL_STATUS_BAD_PARAMS
+ * @param buffer area of memory with size of msg_info.size where parsed message will be putted,
+ * if buffer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS
+ *
+ * If decoder->tracker is set after this function, ll_latency_begin is called for it
+ * when "begin byte" of message is detected and ll_latency_end when message is parsed
+ * or lost (see ll_latency.h).
+ */
+ll_status_t ll_decoder_init(ll_decoder_t* decoder, ll_message_info_t msg_info, uint8_t* buffer);
+
+/**
+ * @brief This function parses one byte of byte stream. It does constant amount of work
+ * for every byte and doesn't need byte stream to be stored, so it can be called
+ * directly from interrupt handler.
+ *
+ * Parsing is the same as in ll_deserialize with the next differences:
+ * - unescaped "begin byte" inside of message (LL_FRAMING_REJECT and LL_FRAMING_XOR modes)
+ *   means that the end of message was lost, message is reported as too short and
+ *   new message is started, so the next message is not lost (see WARNING above);
+ * - after any error in LL_FRAMING_COBS mode bytes are ignored till the next "end byte".
+ *
+ * @param decoder decoder initialized by ll_decoder_init
+ * @param byte next byte of byte stream
+ * @returns true if message was parsed and is in "buffer" passed to ll_decoder_init,
+ * message stays there until the next byte is pushed. Status of the last ended message
+ * (LL_STATUS_SUCCESS or error) is in decoder->status, it is LL_STATUS_NO_MESSAGE
+ * before the first message ends.
+ */
+bool ll_decoder_push_byte(ll_decoder_t* decoder, uint8_t byte);
+
+/**
+ * @brief This function does the same as ll_decoder_push_byte for every byte of "data"
+ * until message is parsed. Bytes inside of message are copied by runs, so it is much
+ * faster than pushing bytes one by one.
+ *
+ * @param decoder decoder initialized by ll_decoder_init
+ * @param data area of memory with size of "size" which will be parsed,
+ * if data == NULL then function does nothing and returns false
+ * @param size data size
+ * @param consumed pointer to quantity of parsed bytes, it is less than "size" only
+ * if message was parsed before the end of "data",
+ * if consumed == NULL then function does nothing and returns false
+ * @returns true if message was parsed (the same as ll_decoder_push_byte)
+ */
+bool ll_decoder_push(ll_decoder_t* decoder, const uint8_t* data, size_t size, size_t* consumed);
+
+/**
+ * @brief This function initializes encoder which gives serialized message byte by byte
+ * (see ll_encoder_next_byte).
+ *
+ * @param encoder encoder,
+ * if encoder == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info,
+ * if it is not valid (see ll_message_info_valid) then function does nothing and
+ * returns LL_STATUS_BAD_PARAMS
+ * @param data area of memory with size of msg_info.size which will be serialized, it
+ * must not be changed until the last byte is taken,
+ * if data == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS
+ */
+ll_status_t ll_encoder_init(ll_encoder_t* encoder, ll_message_info_t msg_info, const uint8_t* data);
+
+/**
+ * @brief This function gives the next byte of serialized message. Bytes are the same
+ * as ll_serialize writes, but they are made only when they are taken, so serialized
+ * message is not stored anywhere and it can be called directly from interrupt handler.
+ * Every byte takes constant amount of work except the first byte of COBS block
+ * (LL_FRAMING_COBS mode), which looks ahead for the end of the block.
+ *
+ * @param encoder encoder initialized by ll_encoder_init
+ * @param byte pointer where the next byte will be putted
+ * @returns true if byte was putted, false if whole message has been already taken
+ * or encoder == NULL or byte == NULL
+ */
+bool ll_encoder_next_byte(ll_encoder_t* encoder, uint8_t* byte);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
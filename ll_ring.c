@@ -0,0 +1,115 @@
+#include "ll_ring.h"
+
+#include <string.h>
+
+
+ll_status_t ll_ring_init(ll_ring_t* ring, uint8_t* buffer, size_t capacity)
+{
+    if(!ring || !buffer || capacity == 0 || (capacity & (capacity - 1)))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->tail_cache = 0;
+    ring->head_cache = 0;
+    ring->buffer = buffer;
+    ring->capacity = capacity;
+    return LL_STATUS_SUCCESS;
+}
+
+size_t ll_ring_writable(ll_ring_t* ring, uint8_t** data)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head - ring->tail_cache == ring->capacity)
+    {
+        //acquire pairs with release in ll_ring_consume, so consumer doesn't read
+        //bytes after they are overwritten
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+
+    size_t offset = head & (ring->capacity - 1);
+    size_t free_size = ring->capacity - (head - ring->tail_cache);
+    if(free_size > ring->capacity - offset)
+    {
+        free_size = ring->capacity - offset;
+    }
+    *data = ring->buffer + offset;
+    return free_size;
+}
+
+void ll_ring_commit(ll_ring_t* ring, size_t size)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + size, memory_order_release);
+}
+
+size_t ll_ring_write(ll_ring_t* ring, const uint8_t* data, size_t size)
+{
+    size_t written = 0;
+    //free space can wrap, then it is given by two calls
+    for(int part = 0; part < 2 && written < size; part++)
+    {
+        uint8_t* free_space;
+        size_t free_size = ll_ring_writable(ring, &free_space);
+        if(free_size == 0)
+        {
+            break;
+        }
+        if(free_size > size - written)
+        {
+            free_size = size - written;
+        }
+        memcpy(free_space, data + written, free_size);
+        ll_ring_commit(ring, free_size);
+        written += free_size;
+    }
+    return written;
+}
+
+size_t ll_ring_readable(ll_ring_t* ring, ll_span_t spans[2])
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if(ring->head_cache == tail)
+    {
+        //acquire pairs with release in ll_ring_commit, so bytes are visible
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+
+    size_t offset = tail & (ring->capacity - 1);
+    size_t stored = ring->head_cache - tail;
+    size_t first = ring->capacity - offset < stored ? ring->capacity - offset : stored;
+    spans[0].data = ring->buffer + offset;
+    spans[0].size = first;
+    spans[1].data = ring->buffer;
+    spans[1].size = stored - first;
+    return stored;
+}
+
+void ll_ring_consume(ll_ring_t* ring, size_t size)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + size, memory_order_release);
+}
+
+bool ll_ring_decode(ll_ring_t* ring, ll_decoder_t* decoder)
+{
+    if(!ring || !decoder)
+    {
+        return false;
+    }
+
+    ll_span_t spans[2];
+    ll_ring_readable(ring, spans);
+
+    size_t passed = 0;
+    bool parsed = false;
+    for(size_t i = 0; i < 2 && !parsed; i++)
+    {
+        size_t consumed;
+        parsed = ll_decoder_push(decoder, spans[i].data, spans[i].size, &consumed);
+        passed += consumed;
+    }
+    ll_ring_consume(ring, passed);
+    return parsed;
+}
@@ -0,0 +1,139 @@
+/*
+    Lock-free byte ring for one producer thread (for example thread which reads
+serial port) and one consumer thread (thread which parses messages).
+
+    Producer and consumer share only two indexes: "head" is written only by producer
+and "tail" only by consumer. Every index is in its own cache line together with
+the copy of the other index which its owner has seen last time, so threads touch
+cache line of each other only when the copy is not enough (ring looks full to
+producer or empty to consumer).
+
+    Indexes grow without wrapping and capacity is a power of two, so position in
+buffer is (index & (capacity - 1)) and quantity of stored bytes is (head - tail).
+
+    Stored bytes are up to two contiguous spans (the second one appears when bytes
+wrap around the end of buffer). ll_ring_decode passes these spans directly to
+decoder (see ll_decoder_push), so bytes are never copied to linear buffer.
+
+Example:
+    uint8_t storage[4096];
+    ll_ring_t ring;
+    ll_ring_init(&ring, storage, sizeof(storage));
+
+    //producer thread
+    uint8_t* free_space;
+    size_t free_size = ll_ring_writable(&ring, &free_space);
+    ssize_t n = read(fd, free_space, free_size);
+    ll_ring_commit(&ring, n);
+
+    //consumer thread
+    while(ll_ring_decode(&ring, &decoder))
+    {
+        process(decoder.buffer);
+    }
+*/
+
+#ifndef LL_RING_H
+#define LL_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_atomic.h"
+
+
+#define LL_RING_CACHE_LINE 64
+
+typedef struct
+{
+    //written by producer
+    LL_ALIGNAS(LL_RING_CACHE_LINE) LL_ATOMIC(size_t) head;
+    size_t tail_cache; //"tail" seen by producer
+
+    //written by consumer
+    LL_ALIGNAS(LL_RING_CACHE_LINE) LL_ATOMIC(size_t) tail;
+    size_t head_cache; //"head" seen by consumer
+
+    //not changed after ll_ring_init
+    LL_ALIGNAS(LL_RING_CACHE_LINE) uint8_t* buffer;
+    size_t capacity;
+} ll_ring_t;
+
+
+/**
+ * @brief This function initializes empty ring.
+ * @param ring ring,
+ * if ring == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param buffer area of memory with size of "capacity" where bytes will be stored,
+ * if buffer == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param capacity buffer size,
+ * if it is not a power of two then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS
+ */
+ll_status_t ll_ring_init(ll_ring_t* ring, uint8_t* buffer, size_t capacity);
+
+/**
+ * @brief This function gives contiguous free space where producer can put bytes
+ * (for example by read()). Bytes become visible to consumer after ll_ring_commit.
+ * It must be called only from producer thread.
+ * @param ring ring
+ * @param data pointer where pointer to free space will be putted
+ * @returns size of free space, it can be less than whole free space of ring
+ * if free space wraps around the end of buffer
+ */
+size_t ll_ring_writable(ll_ring_t* ring, uint8_t** data);
+
+/**
+ * @brief This function makes bytes putted to space given by ll_ring_writable visible
+ * to consumer. It must be called only from producer thread.
+ * @param ring ring
+ * @param size quantity of putted bytes, it must not be bigger than size of free space
+ */
+void ll_ring_commit(ll_ring_t* ring, size_t size);
+
+/**
+ * @brief This function copies bytes to ring. It must be called only from producer thread.
+ * @param ring ring
+ * @param data area of memory with size of "size" which will be copied
+ * @param size data size
+ * @returns quantity of copied bytes, it is less than "size" if ring is full
+ */
+size_t ll_ring_write(ll_ring_t* ring, const uint8_t* data, size_t size);
+
+/**
+ * @brief This function gives bytes stored in ring without copying. It must be called
+ * only from consumer thread.
+ * @param ring ring
+ * @param spans array of two spans where stored bytes will be putted, the second span is
+ * empty if stored bytes don't wrap around the end of buffer
+ * @returns quantity of stored bytes
+ */
+size_t ll_ring_readable(ll_ring_t* ring, ll_span_t spans[2]);
+
+/**
+ * @brief This function frees bytes given by ll_ring_readable. It must be called only
+ * from consumer thread.
+ * @param ring ring
+ * @param size quantity of freed bytes, it must not be bigger than quantity of stored bytes
+ */
+void ll_ring_consume(ll_ring_t* ring, size_t size);
+
+/**
+ * @brief This function passes stored bytes to decoder (see ll_decoder_push) until message
+ * is parsed and frees passed bytes. It must be called only from consumer thread.
+ * @param ring ring,
+ * if ring == NULL then function does nothing and returns false
+ * @param decoder decoder initialized by ll_decoder_init,
+ * if decoder == NULL then function does nothing and returns false
+ * @returns true if message was parsed and is in buffer of decoder, false if all stored
+ * bytes were passed without parsed message
+ */
+bool ll_ring_decode(ll_ring_t* ring, ll_decoder_t* decoder);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_RING_H
@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_template.h"
+
+#include <string.h>
+
+//slots are aligned to this size
+#define LL_TEMPLATE_ALIGN 8
+
+
+static inline uint64_t ll_template_mix(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0xBF58476D1CE4E5B9u;
+    return hash ^ (hash >> 31);
+}
+
+//hash of message bytes, it is used only to choose group and to skip different messages.
+//Big messages are hashed by 4 independent lanes, so multiplications don't wait for each other
+static uint64_t ll_template_hash(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 0x9E3779B97F4A7C15u ^ size;
+    size_t i = 0;
+    if(size >= 32)
+    {
+        uint64_t lane1 = 0xC2B2AE3D27D4EB4Fu;
+        uint64_t lane2 = 0x165667B19E3779F9u;
+        uint64_t lane3 = 0x27D4EB2F165667C5u;
+        for(; i + 32 <= size; i += 32)
+        {
+            uint64_t words[4];
+            memcpy(words, data + i, 32);
+            hash = ll_template_mix(hash, words[0]);
+            lane1 = ll_template_mix(lane1, words[1]);
+            lane2 = ll_template_mix(lane2, words[2]);
+            lane3 = ll_template_mix(lane3, words[3]);
+        }
+        hash = ll_template_mix(hash, lane1);
+        hash = ll_template_mix(hash, lane2 ^ (lane3 << 1));
+    }
+    for(; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = ll_template_mix(hash, word);
+    }
+    for(; i < size; i++)
+    {
+        hash = ll_template_mix(hash, data[i]);
+    }
+    return hash;
+}
+
+ll_status_t ll_template_cache_init(ll_template_cache_t* cache, ll_message_info_t msg_info, size_t memory)
+{
+    if(!cache || !ll_message_info_valid(msg_info))
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    size_t slot_size = msg_info.size + ll_sizeof_serialized_max(msg_info);
+    slot_size = (slot_size + LL_TEMPLATE_ALIGN - 1) / LL_TEMPLATE_ALIGN * LL_TEMPLATE_ALIGN;
+    size_t entry_size = slot_size + sizeof(ll_template_entry_t);
+    if(memory / entry_size < LL_TEMPLATE_WAYS)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    size_t groups = 1;
+    while(groups * 2 <= memory / entry_size / LL_TEMPLATE_WAYS)
+    {
+        groups *= 2;
+    }
+
+    size_t entries = groups * LL_TEMPLATE_WAYS;
+    cache->entries = calloc(entries, sizeof(ll_template_entry_t));
+    cache->slots = malloc(entries * slot_size);
+    if(!cache->entries || !cache->slots)
+    {
+        free(cache->entries);
+        free(cache->slots);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    cache->msg_info = msg_info;
+    cache->slot_size = slot_size;
+    cache->groups = groups;
+    cache->clock = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_template_cache_destroy(ll_template_cache_t* cache)
+{
+    if(!cache)
+    {
+        return;
+    }
+    free(cache->entries);
+    free(cache->slots);
+    cache->entries = NULL;
+    cache->slots = NULL;
+}
+
+const uint8_t* ll_template_get(ll_template_cache_t* cache, const uint8_t* data_in, size_t* size)
+{
+    if(!cache || !data_in || !size)
+    {
+        return NULL;
+    }
+
+    size_t message_size = cache->msg_info.size;
+    uint64_t hash = ll_template_hash(data_in, message_size);
+    size_t first = (size_t)(hash & (cache->groups - 1)) * LL_TEMPLATE_WAYS;
+    size_t victim = first;
+    cache->clock++;
+
+    for(size_t i = first; i < first + LL_TEMPLATE_WAYS; i++)
+    {
+        ll_template_entry_t* entry = &cache->entries[i];
+        uint8_t* slot = cache->slots + i * cache->slot_size;
+        if(entry->size && entry->hash == hash && memcmp(slot, data_in, message_size) == 0)
+        {
+            entry->last_use = cache->clock;
+            cache->hits++;
+            *size = entry->size;
+            return slot + message_size;
+        }
+        //empty entry has last_use 0, so it is taken before used ones
+        if(entry->last_use < cache->entries[victim].last_use)
+        {
+            victim = i;
+        }
+    }
+
+    //message is saved with frame, so frame is never given for other message with the same hash
+    ll_template_entry_t* entry = &cache->entries[victim];
+    uint8_t* slot = cache->slots + victim * cache->slot_size;
+    memcpy(slot, data_in, message_size);
+    entry->hash = hash;
+    entry->last_use = cache->clock;
+    entry->size = ll_serialize(cache->msg_info, data_in, slot + message_size);
+    cache->misses++;
+    *size = entry->size;
+    return slot + message_size;
+}
+
+size_t ll_template_serialize(ll_template_cache_t* cache, const uint8_t* data_in, uint8_t* data_out)
+{
+    if(!data_out)
+    {
+        return 0;
+    }
+    size_t size = 0;
+    const uint8_t* frame = ll_template_get(cache, data_in, &size);
+    if(!frame)
+    {
+        return 0;
+    }
+    memcpy(data_out, frame, size);
+    return size;
+}
@@ -0,0 +1,109 @@
+/*
+    Cache of serialized messages for messages which are sent many times with the same
+bytes (heartbeats, statuses). Serialized frame of message is saved by content of message,
+so the next serializing of the same message is one copy of saved frame instead of escaping
+and checksum.
+
+    Cache has fixed memory which is allocated by ll_template_cache_init: every entry keeps
+message and its serialized frame (msg_info.size + ll_sizeof_serialized_max bytes).
+Entries are grouped by LL_TEMPLATE_WAYS, message can be saved only in the group chosen by
+hash of its bytes, and the least recently used entry of group is replaced by new message.
+Hash is used only to find entry, message is always compared with saved one, so collision
+of hashes never gives wrong frame.
+
+    Cache is not thread safe, every sending thread should have its own cache.
+
+Example:
+    ll_template_cache_t cache;
+    ll_template_cache_init(&cache, msg_info, 64 * 1024);
+
+    size_t size;
+    const uint8_t* frame = ll_template_get(&cache, heartbeat, &size);
+    write(fd, frame, size);
+
+    ll_template_cache_destroy(&cache);
+*/
+
+#ifndef LL_TEMPLATE_H
+#define LL_TEMPLATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+
+//quantity of entries in one group
+#define LL_TEMPLATE_WAYS 4
+
+typedef struct
+{
+    uint64_t hash;
+    uint64_t last_use; //value of cache->clock when entry was used
+    size_t   size;     //size of serialized frame, 0 for empty entry
+} ll_template_entry_t;
+
+typedef struct
+{
+    ll_message_info_t    msg_info;
+    ll_template_entry_t* entries;
+    uint8_t*             slots;     //message and its frame for every entry
+    size_t               slot_size;
+    size_t               groups;    //quantity of groups, power of two
+    uint64_t             clock;     //quantity of lookups, it orders uses of entries
+    uint64_t             hits;      //quantity of messages taken from cache
+    uint64_t             misses;    //quantity of messages which were serialized
+} ll_template_cache_t;
+
+
+/**
+ * @brief This function allocates empty cache.
+ * @param cache cache,
+ * if cache == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param msg_info message info,
+ * if it is not valid (see ll_message_info_valid) then function does nothing and
+ * returns LL_STATUS_BAD_PARAMS
+ * @param memory maximal size of memory for entries, quantity of entries is the biggest
+ * power of two which fits into it,
+ * if it is less than LL_TEMPLATE_WAYS entries then function does nothing and
+ * returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_template_cache_init(ll_template_cache_t* cache, ll_message_info_t msg_info, size_t memory);
+
+/**
+ * @brief This function frees memory of cache.
+ * @param cache cache,
+ * if cache == NULL then function does nothing
+ */
+void ll_template_cache_destroy(ll_template_cache_t* cache);
+
+/**
+ * @brief This function gives serialized frame of message from cache. If message is not
+ * in cache, it is serialized by ll_serialize and saved to cache.
+ * @param cache cache,
+ * if cache == NULL then function does nothing and returns NULL
+ * @param data_in the same as in ll_serialize,
+ * if data_in == NULL then function does nothing and returns NULL
+ * @param size size of frame will be putted here,
+ * if size == NULL then function does nothing and returns NULL
+ * @returns pointer to frame in cache, it is valid until the next call for this cache
+ */
+const uint8_t* ll_template_get(ll_template_cache_t* cache, const uint8_t* data_in, size_t* size);
+
+/**
+ * @brief This function does the same as ll_serialize using cache (see ll_template_get).
+ * @param cache cache,
+ * if cache == NULL then function does nothing and returns 0
+ * @param data_in the same as in ll_serialize
+ * @param data_out the same as in ll_serialize
+ * @returns the same as ll_serialize
+ */
+size_t ll_template_serialize(ll_template_cache_t* cache, const uint8_t* data_in, uint8_t* data_out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_TEMPLATE_H
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_tx_queue.h"
+
+#include <limits.h>
+#include <string.h>
+
+//records are aligned to this size, one commit flag is used for every such part of buffer
+#define LL_TX_QUEUE_ALIGN 8
+
+//quantity of messages written by one ll_tx_queue_flush
+#define LL_TX_QUEUE_IOV 64
+
+
+//header of record, record of padding has size 0
+typedef struct
+{
+    uint32_t size;   //size of message
+    uint32_t length; //size of record with header
+} ll_tx_record_t;
+
+
+static inline size_t ll_tx_queue_slot(const ll_tx_queue_t* queue, size_t position)
+{
+    return (position & (queue->capacity - 1)) / LL_TX_QUEUE_ALIGN;
+}
+
+static inline ll_tx_record_t* ll_tx_queue_record(const ll_tx_queue_t* queue, size_t position)
+{
+    return (ll_tx_record_t*)(queue->buffer + (position & (queue->capacity - 1)));
+}
+
+ll_status_t ll_tx_queue_init(ll_tx_queue_t* queue, size_t capacity)
+{
+    if(!queue || capacity < 64 || (capacity & (capacity - 1)) || capacity > UINT32_MAX)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    queue->buffer = aligned_alloc(LL_TX_QUEUE_CACHE_LINE, capacity);
+    queue->committed = malloc(capacity / LL_TX_QUEUE_ALIGN * sizeof(*queue->committed));
+    if(!queue->buffer || !queue->committed)
+    {
+        free(queue->buffer);
+        free((void*)queue->committed);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    for(size_t i = 0; i < capacity / LL_TX_QUEUE_ALIGN; i++)
+    {
+        atomic_init(&queue->committed[i], 0);
+    }
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->written = 0;
+    queue->capacity = capacity;
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_tx_queue_destroy(ll_tx_queue_t* queue)
+{
+    if(!queue)
+    {
+        return;
+    }
+    free(queue->buffer);
+    free((void*)queue->committed);
+    queue->buffer = NULL;
+    queue->committed = NULL;
+}
+
+uint8_t* ll_tx_queue_reserve(ll_tx_queue_t* queue, size_t size)
+{
+    if(size > queue->capacity - sizeof(ll_tx_record_t))
+    {
+        return NULL;
+    }
+    size_t length = (sizeof(ll_tx_record_t) + size + LL_TX_QUEUE_ALIGN - 1) & ~(size_t)(LL_TX_QUEUE_ALIGN - 1);
+
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t padding;
+    do
+    {
+        //record doesn't wrap around the end of buffer
+        size_t offset = head & (queue->capacity - 1);
+        padding = queue->capacity - offset < length ? queue->capacity - offset : 0;
+
+        //acquire pairs with release in ll_tx_queue_release, so freed space isn't
+        //overwritten while writer still reads it
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if(head + padding + length - tail > queue->capacity)
+        {
+            return NULL;
+        }
+    }
+    while(!atomic_compare_exchange_weak_explicit(&queue->head, &head, head + padding + length,
+                                                 memory_order_relaxed, memory_order_relaxed));
+
+    if(padding)
+    {
+        ll_tx_record_t* record = ll_tx_queue_record(queue, head);
+        record->size = 0;
+        record->length = (uint32_t)padding;
+        atomic_store_explicit(&queue->committed[ll_tx_queue_slot(queue, head)], 1, memory_order_release);
+        head += padding;
+    }
+
+    ll_tx_record_t* record = ll_tx_queue_record(queue, head);
+    record->length = (uint32_t)length;
+    return (uint8_t*)(record + 1);
+}
+
+void ll_tx_queue_commit(ll_tx_queue_t* queue, uint8_t* reserved, size_t size)
+{
+    ll_tx_record_t* record = (ll_tx_record_t*)reserved - 1;
+    record->size = (uint32_t)size;
+    //release pairs with acquire in ll_tx_queue_peek, so message is visible to writer
+    atomic_store_explicit(&queue->committed[((uint8_t*)record - queue->buffer) / LL_TX_QUEUE_ALIGN],
+                          1,
+                          memory_order_release);
+}
+
+bool ll_tx_queue_send(ll_tx_queue_t* queue, ll_message_info_t msg_info, const uint8_t* data)
+{
+    if(!queue || !data || !ll_message_info_valid(msg_info))
+    {
+        return false;
+    }
+    uint8_t* reserved = ll_tx_queue_reserve(queue, ll_sizeof_serialized_max(msg_info));
+    if(!reserved)
+    {
+        return false;
+    }
+    ll_tx_queue_commit(queue, reserved, ll_serialize(msg_info, data, reserved));
+    return true;
+}
+
+size_t ll_tx_queue_peek(ll_tx_queue_t* queue, struct iovec* iov, size_t iov_max)
+{
+    size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t written = queue->written;
+    size_t count = 0;
+
+    while(   count < iov_max
+          && position != head
+          && atomic_load_explicit(&queue->committed[ll_tx_queue_slot(queue, position)], memory_order_acquire))
+    {
+        ll_tx_record_t* record = ll_tx_queue_record(queue, position);
+        if(record->size)
+        {
+            iov[count].iov_base = (uint8_t*)(record + 1) + written;
+            iov[count].iov_len = record->size - written;
+            count++;
+            written = 0;
+        }
+        position += record->length;
+    }
+    return count;
+}
+
+void ll_tx_queue_release(ll_tx_queue_t* queue, size_t size)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    //padding records after released messages are also released
+    while(tail != head)
+    {
+        LL_ATOMIC(uint8_t)* committed = &queue->committed[ll_tx_queue_slot(queue, tail)];
+        if(!atomic_load_explicit(committed, memory_order_acquire))
+        {
+            break;
+        }
+
+        ll_tx_record_t* record = ll_tx_queue_record(queue, tail);
+        size_t rest = record->size - queue->written;
+        if(rest > size)
+        {
+            queue->written += size;
+            break;
+        }
+        size -= rest;
+        queue->written = 0;
+        atomic_store_explicit(committed, 0, memory_order_relaxed);
+        tail += record->length;
+    }
+
+    //release pairs with acquire in ll_tx_queue_reserve
+    atomic_store_explicit(&queue->tail, tail, memory_order_release);
+}
+
+ssize_t ll_tx_queue_flush(ll_tx_queue_t* queue, int fd)
+{
+    if(!queue)
+    {
+        return -1;
+    }
+
+    struct iovec iov[LL_TX_QUEUE_IOV];
+    size_t count = ll_tx_queue_peek(queue, iov, LL_TX_QUEUE_IOV);
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    ssize_t result = writev(fd, iov, (int)count);
+    if(result > 0)
+    {
+        ll_tx_queue_release(queue, (size_t)result);
+    }
+    return result;
+}
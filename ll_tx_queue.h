@@ -0,0 +1,147 @@
+/*
+    Transmit queue for many threads which send messages over one byte stream
+(for example serial port) and one thread which writes them.
+
+    Sender reserves space for the biggest serialized message (ll_sizeof_serialized_max),
+serializes message directly to reserved space and commits it. Only reserving takes
+one compare-and-swap on shared index, serializing is done without any lock, so senders
+don't wait for each other. Writer takes committed messages in order of reserving and
+writes them with one writev() call.
+
+    Every message is stored as record: 8 bytes header (size of message and size of
+record) followed by message. Records are aligned to 8 bytes. If record doesn't fit
+before the end of buffer, the rest of buffer is filled with empty record and record
+starts at the beginning of buffer. Commit flags are stored in separate array, one flag
+per 8 bytes of buffer, so writer never sees flag of old record as flag of new one.
+
+    Writer stops at the first record which is not committed yet, so slow sender delays
+messages reserved after it, but their order is always the order of reserving.
+
+Example:
+    ll_tx_queue_t queue;
+    ll_tx_queue_init(&queue, 1 << 20);
+
+    //any sender thread
+    if(!ll_tx_queue_send(&queue, msg_info, data))
+    {
+        //queue is full
+    }
+
+    //writer thread
+    ll_tx_queue_flush(&queue, fd);
+*/
+
+#ifndef LL_TX_QUEUE_H
+#define LL_TX_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_atomic.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+
+#define LL_TX_QUEUE_CACHE_LINE 64
+
+typedef struct
+{
+    //written by senders
+    LL_ALIGNAS(LL_TX_QUEUE_CACHE_LINE) LL_ATOMIC(size_t) head;
+
+    //written by writer
+    LL_ALIGNAS(LL_TX_QUEUE_CACHE_LINE) LL_ATOMIC(size_t) tail;
+    size_t written; //bytes of the first message which are already written
+
+    //not changed after ll_tx_queue_init
+    LL_ALIGNAS(LL_TX_QUEUE_CACHE_LINE) uint8_t* buffer;
+    LL_ATOMIC(uint8_t)* committed; //commit flag for every 8 bytes of buffer
+    size_t capacity;
+} ll_tx_queue_t;
+
+
+/**
+ * @brief This function allocates empty queue.
+ * @param queue queue,
+ * if queue == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param capacity size of buffer for records, it limits size of reserved space,
+ * if it is not a power of two or less than 64 then function does nothing
+ * and returns LL_STATUS_BAD_PARAMS
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_tx_queue_init(ll_tx_queue_t* queue, size_t capacity);
+
+/**
+ * @brief This function frees memory of queue.
+ * @param queue queue,
+ * if queue == NULL then function does nothing
+ */
+void ll_tx_queue_destroy(ll_tx_queue_t* queue);
+
+/**
+ * @brief This function reserves space for message. It can be called from any thread.
+ * Reserved space must be committed by ll_tx_queue_commit, writer waits for it.
+ * @param queue queue
+ * @param size size of reserved space
+ * @returns pointer to reserved space, NULL if queue is full
+ */
+uint8_t* ll_tx_queue_reserve(ll_tx_queue_t* queue, size_t size);
+
+/**
+ * @brief This function makes message in reserved space visible to writer.
+ * @param queue queue
+ * @param reserved pointer returned by ll_tx_queue_reserve
+ * @param size size of message, it must not be bigger than size of reserved space
+ */
+void ll_tx_queue_commit(ll_tx_queue_t* queue, uint8_t* reserved, size_t size);
+
+/**
+ * @brief This function serializes message to queue (reserves space, calls ll_serialize
+ * and commits). It can be called from any thread.
+ * @param queue queue,
+ * if queue == NULL then function does nothing and returns false
+ * @param msg_info message info
+ * @param data the same as "data_in" in ll_serialize,
+ * if data == NULL or msg_info is not valid then function does nothing and returns false
+ * @returns true if message was put to queue, false if queue is full
+ */
+bool ll_tx_queue_send(ll_tx_queue_t* queue, ll_message_info_t msg_info, const uint8_t* data);
+
+/**
+ * @brief This function gives committed messages which are not written yet in order
+ * of reserving. It must be called only from writer thread.
+ * @param queue queue
+ * @param iov array with size of iov_max where messages will be putted, messages are not
+ * copied, they stay in queue until ll_tx_queue_release is called
+ * @param iov_max maximal quantity of messages
+ * @returns quantity of messages putted to "iov"
+ */
+size_t ll_tx_queue_peek(ll_tx_queue_t* queue, struct iovec* iov, size_t iov_max);
+
+/**
+ * @brief This function frees written bytes of messages given by ll_tx_queue_peek.
+ * Message which is written partly stays in queue and the next ll_tx_queue_peek gives
+ * only its rest. It must be called only from writer thread.
+ * @param queue queue
+ * @param size quantity of written bytes
+ */
+void ll_tx_queue_release(ll_tx_queue_t* queue, size_t size);
+
+/**
+ * @brief This function writes committed messages to file descriptor with one writev()
+ * and frees written bytes. It must be called only from writer thread.
+ * @param queue queue,
+ * if queue == NULL then function does nothing and returns -1
+ * @param fd file descriptor
+ * @returns result of writev() (-1 with errno on error), 0 if there are no committed messages
+ */
+ssize_t ll_tx_queue_flush(ll_tx_queue_t* queue, int fd);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_TX_QUEUE_H
@@ -0,0 +1,218 @@
+#define _GNU_SOURCE
+
+#include "ll_udp.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/socket.h>
+
+
+ll_status_t ll_udp_sender_init(ll_udp_sender_t* sender, int fd, ll_message_info_t msg_info,
+                               size_t datagram_size, size_t batch_max)
+{
+    if(!sender || fd < 0 || !ll_message_info_valid(msg_info) || batch_max == 0 || batch_max > UINT_MAX)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    memset(sender, 0, sizeof(*sender));
+
+    size_t serialized_max = ll_sizeof_serialized_max(msg_info);
+    sender->fd = fd;
+    sender->msg_info = msg_info;
+    sender->datagram_size = datagram_size > serialized_max ? datagram_size : serialized_max;
+    sender->batch_max = batch_max;
+    sender->buffers = malloc(batch_max * sender->datagram_size);
+    sender->iov = calloc(batch_max, sizeof(*sender->iov));
+    sender->msgs = calloc(batch_max, sizeof(*sender->msgs));
+    if(!sender->buffers || !sender->iov || !sender->msgs)
+    {
+        ll_udp_sender_destroy(sender);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    for(size_t i = 0; i < batch_max; i++)
+    {
+        sender->iov[i].iov_base = sender->buffers + i * sender->datagram_size;
+        sender->msgs[i].msg_hdr.msg_iov = &sender->iov[i];
+        sender->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_udp_sender_destroy(ll_udp_sender_t* sender)
+{
+    if(!sender)
+    {
+        return;
+    }
+    free(sender->buffers);
+    free(sender->iov);
+    free(sender->msgs);
+    memset(sender, 0, sizeof(*sender));
+    sender->fd = -1;
+}
+
+//sends datagrams until all are sent or sendmmsg fails, returns quantity of sent datagrams
+static size_t ll_udp_send_batch(ll_udp_sender_t* sender)
+{
+    size_t sent = 0;
+    while(sent < sender->count)
+    {
+        int result = sendmmsg(sender->fd, sender->msgs + sent, (unsigned)(sender->count - sent), 0);
+        if(result < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        sent += (size_t)result;
+    }
+
+    //datagrams which were not sent are moved to the beginning of batch
+    size_t left = sender->count - sent;
+    for(size_t i = 0; i < left; i++)
+    {
+        memcpy(sender->iov[i].iov_base, sender->iov[sent + i].iov_base, sender->iov[sent + i].iov_len);
+        sender->iov[i].iov_len = sender->iov[sent + i].iov_len;
+    }
+    sender->count = left;
+    return sent;
+}
+
+int ll_udp_flush(ll_udp_sender_t* sender)
+{
+    if(!sender)
+    {
+        return -1;
+    }
+
+    size_t sent = ll_udp_send_batch(sender);
+    return sender->count ? -1 : (int)sent;
+}
+
+int ll_udp_send(ll_udp_sender_t* sender, const uint8_t* data)
+{
+    if(!sender || !data)
+    {
+        return -1;
+    }
+
+    size_t serialized_max = ll_sizeof_serialized_max(sender->msg_info);
+    int sent = 0;
+    if(   sender->count == 0
+       || sender->datagram_size - sender->iov[sender->count - 1].iov_len < serialized_max)
+    {
+        //batch is sent only when the next message doesn't fit, so datagrams are always full
+        if(sender->count == sender->batch_max)
+        {
+            //datagrams sent before error are counted, message is put if any datagram was sent
+            sent = (int)ll_udp_send_batch(sender);
+            if(sender->count == sender->batch_max)
+            {
+                return -1;
+            }
+        }
+        sender->iov[sender->count].iov_len = 0;
+        sender->count++;
+    }
+
+    struct iovec* iov = &sender->iov[sender->count - 1];
+    iov->iov_len += ll_serialize(sender->msg_info, data, (uint8_t*)iov->iov_base + iov->iov_len);
+    return sent;
+}
+
+ll_status_t ll_udp_receiver_init(ll_udp_receiver_t* receiver, int fd, ll_message_info_t msg_info,
+                                 uint8_t* buffer, size_t datagram_size, size_t batch_max)
+{
+    if(!receiver || fd < 0 || datagram_size == 0 || batch_max == 0 || batch_max > UINT_MAX)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    memset(receiver, 0, sizeof(*receiver));
+    if(ll_decoder_init(&receiver->decoder, msg_info, buffer) != LL_STATUS_SUCCESS)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    receiver->fd = fd;
+    receiver->datagram_size = datagram_size;
+    receiver->batch_max = batch_max;
+    receiver->buffers = malloc(batch_max * datagram_size);
+    receiver->iov = calloc(batch_max, sizeof(*receiver->iov));
+    receiver->msgs = calloc(batch_max, sizeof(*receiver->msgs));
+    if(!receiver->buffers || !receiver->iov || !receiver->msgs)
+    {
+        ll_udp_receiver_destroy(receiver);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    for(size_t i = 0; i < batch_max; i++)
+    {
+        receiver->iov[i].iov_base = receiver->buffers + i * datagram_size;
+        receiver->iov[i].iov_len = datagram_size;
+        receiver->msgs[i].msg_hdr.msg_iov = &receiver->iov[i];
+        receiver->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_udp_receiver_destroy(ll_udp_receiver_t* receiver)
+{
+    if(!receiver)
+    {
+        return;
+    }
+    free(receiver->buffers);
+    free(receiver->iov);
+    free(receiver->msgs);
+    memset(receiver, 0, sizeof(*receiver));
+    receiver->fd = -1;
+}
+
+int ll_udp_receive(ll_udp_receiver_t* receiver, ll_udp_callback_t callback, void* context)
+{
+    if(!receiver || !callback)
+    {
+        return -1;
+    }
+
+    //blocking socket waits only for the first datagram, then takes what is ready
+    int count;
+    do
+    {
+        count = recvmmsg(receiver->fd, receiver->msgs, (unsigned)receiver->batch_max, MSG_WAITFORONE, NULL);
+    }
+    while(count < 0 && errno == EINTR);
+    if(count < 0)
+    {
+        return -1;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        //tail of datagram bigger than datagram_size is discarded by kernel, so its
+        //last message is broken and the whole datagram is skipped
+        if(receiver->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            receiver->truncated++;
+            continue;
+        }
+
+        const uint8_t* data = receiver->iov[i].iov_base;
+        size_t size = receiver->msgs[i].msg_len;
+        while(size > 0)
+        {
+            size_t consumed;
+            if(ll_decoder_push(&receiver->decoder, data, size, &consumed))
+            {
+                callback(context, receiver->decoder.buffer);
+            }
+            data += consumed;
+            size -= consumed;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,150 @@
+/*
+    Transport of byte stream with messages over UDP, many datagrams are sent and
+received by one system call (sendmmsg and recvmmsg).
+
+    Sender serializes messages directly to datagram buffers. Messages are packed
+to the current datagram while it has space for serialized message (datagram_size),
+then the next datagram is used. When all datagrams of batch are used (or
+ll_udp_flush is called) they are sent by one sendmmsg.
+
+    Receiver takes all datagrams which are ready (up to batch size) by one recvmmsg
+and parses them in order by one decoder (see ll_decoder_push), so message can
+continue from one datagram to another. If datagram is lost, decoder skips broken
+message and finds the next one.
+
+    Sender socket must be connected (connect()) to receiver and receiver socket must
+be bound, datagrams from all sources are parsed as one byte stream.
+*/
+
+#ifndef LL_UDP_H
+#define LL_UDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+
+#include <sys/types.h>
+
+
+/**
+ * @brief Callback which is called for every parsed message.
+ * @param context context which was passed to ll_udp_receive
+ * @param data parsed message with size of msg_info.size, it is valid only during the call
+ */
+typedef void (*ll_udp_callback_t)(void* context, const uint8_t* data);
+
+typedef struct
+{
+    int               fd;
+    ll_message_info_t msg_info;
+    size_t            datagram_size; //size of datagram buffer
+    size_t            batch_max;     //quantity of datagrams sent by one sendmmsg
+    size_t            count;         //quantity of used datagrams, the last one is filled
+    uint8_t*          buffers;
+    struct iovec*     iov;
+    struct mmsghdr*   msgs;
+} ll_udp_sender_t;
+
+typedef struct
+{
+    int             fd;
+    ll_decoder_t    decoder;
+    size_t          datagram_size;
+    size_t          batch_max;
+    uint64_t        truncated; //quantity of skipped datagrams bigger than datagram_size
+    uint8_t*        buffers;
+    struct iovec*   iov;
+    struct mmsghdr* msgs;
+} ll_udp_receiver_t;
+
+
+/**
+ * @brief This function allocates sender.
+ * @param sender sender,
+ * if sender == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param fd connected UDP socket
+ * @param msg_info message info,
+ * if it is not valid then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param datagram_size maximal size of datagram, it is increased to
+ * ll_sizeof_serialized_max(msg_info) if it is smaller
+ * @param batch_max quantity of datagrams sent by one system call
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_udp_sender_init(ll_udp_sender_t* sender, int fd, ll_message_info_t msg_info,
+                               size_t datagram_size, size_t batch_max);
+
+/**
+ * @brief This function frees memory of sender, unsent datagrams are lost.
+ * Socket is not closed.
+ * @param sender sender,
+ * if sender == NULL then function does nothing
+ */
+void ll_udp_sender_destroy(ll_udp_sender_t* sender);
+
+/**
+ * @brief This function serializes message to datagram. Datagrams are sent when
+ * batch is full and message doesn't fit to the last datagram, so ll_udp_flush must be
+ * called to send the rest of messages.
+ * @param sender sender,
+ * if sender == NULL then function does nothing and returns -1
+ * @param data the same as "data_in" in ll_serialize,
+ * if data == NULL then function does nothing and returns -1
+ * @returns quantity of sent datagrams (also if only part of full batch was sent),
+ * -1 with errno if message wasn't put because batch is full and sendmmsg failed
+ * before any datagram was sent
+ */
+int ll_udp_send(ll_udp_sender_t* sender, const uint8_t* data);
+
+/**
+ * @brief This function sends all filled datagrams by sendmmsg.
+ * @param sender sender,
+ * if sender == NULL then function does nothing and returns -1
+ * @returns quantity of sent datagrams, -1 with errno if sendmmsg failed (datagrams
+ * which were not sent stay in sender)
+ */
+int ll_udp_flush(ll_udp_sender_t* sender);
+
+/**
+ * @brief This function allocates receiver.
+ * @param receiver receiver,
+ * if receiver == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param fd bound UDP socket
+ * @param msg_info message info
+ * @param buffer area of memory with size of msg_info.size where parsed message will be putted
+ * @param datagram_size maximal size of received datagram
+ * @param batch_max quantity of datagrams received by one system call
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if memory can't be allocated)
+ */
+ll_status_t ll_udp_receiver_init(ll_udp_receiver_t* receiver, int fd, ll_message_info_t msg_info,
+                                 uint8_t* buffer, size_t datagram_size, size_t batch_max);
+
+/**
+ * @brief This function frees memory of receiver. Socket is not closed.
+ * @param receiver receiver,
+ * if receiver == NULL then function does nothing
+ */
+void ll_udp_receiver_destroy(ll_udp_receiver_t* receiver);
+
+/**
+ * @brief This function receives ready datagrams by recvmmsg and calls callback for
+ * every parsed message. If socket is blocking, it waits for the first datagram.
+ * Datagrams which were truncated because they are bigger than datagram_size are
+ * not parsed, they are counted in receiver->truncated.
+ * @param receiver receiver,
+ * if receiver == NULL then function does nothing and returns -1
+ * @param callback callback,
+ * if callback == NULL then function does nothing and returns -1
+ * @param context context passed to "callback"
+ * @returns quantity of received datagrams (including truncated ones), -1 with errno
+ * if recvmmsg failed
+ * (EAGAIN if socket is non-blocking and there are no datagrams)
+ */
+int ll_udp_receive(ll_udp_receiver_t* receiver, ll_udp_callback_t callback, void* context);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_UDP_H
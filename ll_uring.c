@@ -0,0 +1,456 @@
+#define _GNU_SOURCE
+
+#include "ll_uring.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//opcode of multishot read (Linux 6.7), it is not in older headers
+#define LL_URING_OP_READ_MULTISHOT 49
+
+//group of provided buffers
+#define LL_URING_BUFFER_GROUP 0
+
+//maximal quantity of provided buffers supported by kernel
+#define LL_URING_BUFFERS_MAX 32768
+
+//size of buffer for bytes which are read after hang up
+#define LL_URING_DRAIN_SIZE 1024
+
+//kind of request is in low bits of user_data, index of device is in high bits
+enum
+{
+    LL_URING_READ,
+    LL_URING_HANGUP, //poll for hang up, read isn't completed on hang up of pseudo terminal
+    LL_URING_CANCEL,
+    LL_URING_KINDS = 4
+};
+
+
+static int ll_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ll_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int ll_uring_register(int ring_fd, unsigned opcode, void* arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+//gives buffer back to kernel, it is visible to kernel after ll_uring_publish_buffers
+static void ll_uring_recycle_buffer(ll_uring_t* uring, unsigned id)
+{
+    struct io_uring_buf* buf = &uring->buf_ring->bufs[uring->buf_tail & (uring->buffer_count - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(uring->buffers + (size_t)id * uring->buffer_size);
+    buf->len = (uint32_t)uring->buffer_size;
+    buf->bid = (uint16_t)id;
+    uring->buf_tail++;
+}
+
+static void ll_uring_publish_buffers(ll_uring_t* uring)
+{
+    //release makes filled buffer entries visible before new tail
+    atomic_store_explicit((_Atomic uint16_t*)&uring->buf_ring->tail,
+                          (uint16_t)uring->buf_tail,
+                          memory_order_release);
+}
+
+//prepares request, it is submitted by the next ll_uring_run
+static struct io_uring_sqe* ll_uring_prepare(ll_uring_t* uring, size_t device, unsigned kind)
+{
+    unsigned index = (*uring->sq_tail + uring->sq_pending) & uring->sq_mask;
+    struct io_uring_sqe* sqe = &uring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = uring->devices[device].fd;
+    sqe->user_data = (uint64_t)device * LL_URING_KINDS + kind;
+    uring->sq_array[index] = index;
+    uring->sq_pending++;
+    return sqe;
+}
+
+static void ll_uring_arm(ll_uring_t* uring, size_t device)
+{
+    ll_uring_device_t* dev = &uring->devices[device];
+    struct io_uring_sqe* sqe = ll_uring_prepare(uring, device, LL_URING_READ);
+    sqe->opcode = dev->multishot ? LL_URING_OP_READ_MULTISHOT : IORING_OP_READ;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->off = (uint64_t)-1;
+    sqe->len = dev->multishot ? 0 : (uint32_t)uring->buffer_size;
+    sqe->buf_group = LL_URING_BUFFER_GROUP;
+    dev->armed = true;
+}
+
+ll_status_t ll_uring_init(ll_uring_t* uring, size_t devices_max, size_t buffer_count, size_t buffer_size)
+{
+    if(   !uring
+       || devices_max == 0
+       || buffer_count == 0
+       || buffer_count > LL_URING_BUFFERS_MAX
+       || (buffer_count & (buffer_count - 1))
+       || buffer_size == 0
+       || buffer_size > UINT32_MAX)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    memset(uring, 0, sizeof(*uring));
+    uring->ring_fd = -1;
+
+    //every device has at most read, poll and cancel requests in submission queue
+    unsigned entries = 1;
+    while(entries < devices_max * 3)
+    {
+        entries <<= 1;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    uring->ring_fd = ll_uring_setup(entries, &params);
+    if(uring->ring_fd < 0)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(uring->cq_ring_size > uring->sq_ring_size)
+        {
+            uring->sq_ring_size = uring->cq_ring_size;
+        }
+        uring->cq_ring_size = uring->sq_ring_size;
+    }
+
+    uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          uring->ring_fd, IORING_OFF_SQ_RING);
+    if(uring->sq_ring == MAP_FAILED)
+    {
+        uring->sq_ring = NULL;
+        ll_uring_destroy(uring);
+        return LL_STATUS_BAD_PARAMS;
+    }
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        uring->cq_ring = uring->sq_ring;
+    }
+    else
+    {
+        uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              uring->ring_fd, IORING_OFF_CQ_RING);
+        if(uring->cq_ring == MAP_FAILED)
+        {
+            uring->cq_ring = NULL;
+            ll_uring_destroy(uring);
+            return LL_STATUS_BAD_PARAMS;
+        }
+    }
+
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       uring->ring_fd, IORING_OFF_SQES);
+    if(uring->sqes == MAP_FAILED)
+    {
+        uring->sqes = NULL;
+        ll_uring_destroy(uring);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    uint8_t* sq = uring->sq_ring;
+    uint8_t* cq = uring->cq_ring;
+    uring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    uring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    uring->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    uring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    uring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    uring->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    //ring of provided buffers must be page aligned
+    uring->buffer_count = (unsigned)buffer_count;
+    uring->buffer_size = buffer_size;
+    uring->buf_ring = mmap(NULL, buffer_count * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uring->buffers = malloc(buffer_count * buffer_size);
+    uring->devices = malloc(devices_max * sizeof(*uring->devices));
+    if(uring->buf_ring == MAP_FAILED || !uring->buffers || !uring->devices)
+    {
+        if(uring->buf_ring == MAP_FAILED)
+        {
+            uring->buf_ring = NULL;
+        }
+        ll_uring_destroy(uring);
+        errno = ENOMEM;
+        return LL_STATUS_BAD_PARAMS;
+    }
+    uring->devices_max = devices_max;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)uring->buf_ring;
+    reg.ring_entries = (uint32_t)buffer_count;
+    reg.bgid = LL_URING_BUFFER_GROUP;
+    if(ll_uring_register(uring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        ll_uring_destroy(uring);
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    for(unsigned i = 0; i < uring->buffer_count; i++)
+    {
+        ll_uring_recycle_buffer(uring, i);
+    }
+    ll_uring_publish_buffers(uring);
+    return LL_STATUS_SUCCESS;
+}
+
+void ll_uring_destroy(ll_uring_t* uring)
+{
+    if(!uring)
+    {
+        return;
+    }
+    if(uring->sqes)
+    {
+        munmap(uring->sqes, uring->sqes_size);
+    }
+    if(uring->cq_ring && uring->cq_ring != uring->sq_ring)
+    {
+        munmap(uring->cq_ring, uring->cq_ring_size);
+    }
+    if(uring->sq_ring)
+    {
+        munmap(uring->sq_ring, uring->sq_ring_size);
+    }
+    //closing of io_uring cancels requests and unregisters buffers
+    if(uring->ring_fd >= 0)
+    {
+        close(uring->ring_fd);
+    }
+    if(uring->buf_ring)
+    {
+        munmap(uring->buf_ring, uring->buffer_count * sizeof(struct io_uring_buf));
+    }
+    free(uring->buffers);
+    free(uring->devices);
+    memset(uring, 0, sizeof(*uring));
+    uring->ring_fd = -1;
+}
+
+ll_status_t ll_uring_add(ll_uring_t* uring, int fd, ll_message_info_t msg_info, uint8_t* buffer, size_t* device)
+{
+    if(!uring || fd < 0 || !device || uring->devices_count == uring->devices_max)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+
+    ll_uring_device_t* dev = &uring->devices[uring->devices_count];
+    if(ll_decoder_init(&dev->decoder, msg_info, buffer) != LL_STATUS_SUCCESS)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    dev->fd = fd;
+    dev->armed = false;
+    dev->hangup = false;
+    dev->multishot = true;
+    dev->closed = false;
+    dev->error = 0;
+
+    *device = uring->devices_count++;
+    ll_uring_arm(uring, *device);
+    struct io_uring_sqe* sqe = ll_uring_prepare(uring, *device, LL_URING_HANGUP);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->poll32_events = POLLHUP | POLLERR;
+    return LL_STATUS_SUCCESS;
+}
+
+ll_status_t ll_uring_trace(ll_uring_t* uring, size_t device, ll_latency_tracker_t* tracker)
+{
+    if(!uring || device >= uring->devices_count)
+    {
+        return LL_STATUS_BAD_PARAMS;
+    }
+    uring->devices[device].decoder.tracker = tracker;
+    return LL_STATUS_SUCCESS;
+}
+
+static void ll_uring_parse(ll_uring_t* uring,
+                           size_t device,
+                           const uint8_t* data,
+                           size_t size,
+                           ll_uring_callback_t callback,
+                           void* context)
+{
+    ll_decoder_t* decoder = &uring->devices[device].decoder;
+    while(size > 0)
+    {
+        size_t consumed;
+        if(ll_decoder_push(decoder, data, size, &consumed))
+        {
+            callback(context, device, decoder->buffer);
+        }
+        data += consumed;
+        size -= consumed;
+    }
+}
+
+//reads bytes which are left after hang up, reading never blocks after hang up
+static void ll_uring_drain(ll_uring_t* uring, size_t device, ll_uring_callback_t callback, void* context)
+{
+    uint8_t data[LL_URING_DRAIN_SIZE];
+    ssize_t size;
+    while((size = read(uring->devices[device].fd, data, sizeof(data))) > 0)
+    {
+        ll_uring_parse(uring, device, data, (size_t)size, callback, context);
+    }
+}
+
+static void ll_uring_complete(ll_uring_t* uring,
+                              const struct io_uring_cqe* cqe,
+                              ll_uring_callback_t callback,
+                              void* context)
+{
+    size_t device = (size_t)(cqe->user_data / LL_URING_KINDS);
+    unsigned kind = (unsigned)(cqe->user_data % LL_URING_KINDS);
+    ll_uring_device_t* dev = &uring->devices[device];
+
+    if(dev->closed)
+    {
+        return;
+    }
+    if(kind == LL_URING_CANCEL)
+    {
+        //read was completed before cancel, it is canceled again when it is armed
+        if(cqe->res == -ENOENT)
+        {
+            dev->hangup = true;
+        }
+        return;
+    }
+    if(kind == LL_URING_HANGUP)
+    {
+        //read may be not armed now (single read between completions or multishot read
+        //ended by -ENOBUFS), so it is canceled by ll_uring_run after it is armed again
+        if(cqe->res > 0)
+        {
+            dev->hangup = true;
+        }
+        return;
+    }
+
+    if(cqe->flags & IORING_CQE_F_BUFFER)
+    {
+        unsigned id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if(cqe->res > 0)
+        {
+            ll_uring_parse(uring, device, uring->buffers + (size_t)id * uring->buffer_size,
+                           (size_t)cqe->res, callback, context);
+        }
+        ll_uring_recycle_buffer(uring, id);
+    }
+
+    if(!(cqe->flags & IORING_CQE_F_MORE))
+    {
+        dev->armed = false;
+    }
+
+    if(cqe->res == 0)
+    {
+        dev->closed = true;
+    }
+    else if(cqe->res == -ECANCELED)
+    {
+        ll_uring_drain(uring, device, callback, context);
+        dev->closed = true;
+    }
+    else if(cqe->res == -EINVAL && dev->multishot)
+    {
+        //kernel doesn't support multishot read
+        dev->multishot = false;
+    }
+    else if(cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -EAGAIN && cqe->res != -EINTR)
+    {
+        dev->closed = true;
+        dev->error = -cqe->res;
+    }
+
+    if(dev->closed)
+    {
+        callback(context, device, NULL);
+    }
+}
+
+int ll_uring_run(ll_uring_t* uring, ll_uring_callback_t callback, void* context)
+{
+    if(!uring || !callback)
+    {
+        return -EINVAL;
+    }
+
+    bool open = false;
+    for(size_t i = 0; i < uring->devices_count; i++)
+    {
+        open = open || !uring->devices[i].closed;
+    }
+    if(!open)
+    {
+        return 0;
+    }
+
+    //release makes prepared requests visible before new tail
+    unsigned sq_tail = *uring->sq_tail + uring->sq_pending;
+    atomic_store_explicit((_Atomic unsigned*)uring->sq_tail, sq_tail, memory_order_release);
+    uring->sq_pending = 0;
+
+    //requests which were not taken by kernel because of interrupted call are submitted again
+    unsigned to_submit = sq_tail - atomic_load_explicit((_Atomic unsigned*)uring->sq_head, memory_order_acquire);
+    if(ll_uring_enter(uring->ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+    {
+        return -errno;
+    }
+
+    //all ready completions are processed, buffers are given back and head is moved once
+    unsigned head = *uring->cq_head;
+    unsigned tail = atomic_load_explicit((_Atomic unsigned*)uring->cq_tail, memory_order_acquire);
+    int count = 0;
+    for(; head != tail; head++, count++)
+    {
+        ll_uring_complete(uring, &uring->cqes[head & uring->cq_mask], callback, context);
+    }
+    atomic_store_explicit((_Atomic unsigned*)uring->cq_head, head, memory_order_release);
+    ll_uring_publish_buffers(uring);
+
+    for(size_t i = 0; i < uring->devices_count; i++)
+    {
+        ll_uring_device_t* dev = &uring->devices[i];
+        if(dev->closed)
+        {
+            continue;
+        }
+        if(!dev->armed)
+        {
+            ll_uring_arm(uring, i);
+        }
+        if(dev->hangup)
+        {
+            //read is completed with -ECANCELED and then the rest of bytes is read
+            struct io_uring_sqe* sqe = ll_uring_prepare(uring, i, LL_URING_CANCEL);
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = (uint64_t)i * LL_URING_KINDS + LL_URING_READ;
+            dev->hangup = false;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,161 @@
+/*
+    Reading of many byte streams (serial ports, pseudo terminals, sockets) with
+Linux io_uring. Every byte stream (device) has its own decoder (see ll_decoder_push),
+so messages are parsed as soon as bytes come and bytes are never copied to
+intermediate buffer.
+
+    Every device has one multishot read request: it is submitted once and then
+kernel completes it every time when bytes come, without new system calls. Kernel
+takes buffers for bytes from ring of provided buffers which is shared by all devices,
+buffer is given back to the ring right after its bytes are parsed. All completions
+which are ready are processed by one call of ll_uring_run and all given back buffers
+are published by one store, so one system call serves many devices and many reads.
+
+    Read of pseudo terminal is not completed when the other side is closed (poll of
+terminal gives only POLLHUP), so every device also has poll request for hang up.
+When it is completed, read is canceled and the rest of bytes is read directly.
+
+    Multishot read (IORING_OP_READ_MULTISHOT) needs Linux 6.7, with older kernels
+simple read with provided buffer is used and it is submitted again after every
+completion. io_uring is used through system calls directly, liburing is not needed.
+
+Example:
+    ll_uring_t uring;
+    ll_uring_init(&uring, 64, 256, 4096);
+    ll_uring_add(&uring, serial_fd, msg_info, message_buffer, &device);
+
+    while(ll_uring_run(&uring, on_message, context) >= 0)
+    {
+    }
+*/
+
+#ifndef LL_URING_H
+#define LL_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "ll_protocol.h"
+#include "ll_latency.h"
+
+
+/**
+ * @brief Callback which is called for every parsed message.
+ * @param context context which was passed to ll_uring_run
+ * @param device index of device returned by ll_uring_add
+ * @param data parsed message with size of msg_info.size of device, it is valid only
+ * during the call, NULL if device was closed (end of file or read error)
+ */
+typedef void (*ll_uring_callback_t)(void* context, size_t device, const uint8_t* data);
+
+typedef struct
+{
+    int          fd;
+    ll_decoder_t decoder;
+    bool         armed;     //read request is submitted
+    bool         hangup;    //hang up was detected, read must be canceled after it is armed
+    bool         multishot; //multishot read is supported for this device
+    bool         closed;    //end of file or read error, device is not read anymore
+    int          error;     //errno of read error, 0 for end of file
+} ll_uring_device_t;
+
+typedef struct
+{
+    int ring_fd;
+
+    //submission queue
+    unsigned*            sq_head;
+    unsigned*            sq_tail;
+    unsigned             sq_mask;
+    unsigned*            sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned             sq_pending; //prepared requests which are not submitted yet
+
+    //completion queue
+    unsigned*            cq_head;
+    unsigned*            cq_tail;
+    unsigned             cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void*  sq_ring;
+    size_t sq_ring_size;
+    void*  cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+
+    //provided buffers
+    struct io_uring_buf_ring* buf_ring;
+    uint8_t*                  buffers;
+    size_t                    buffer_size;
+    unsigned                  buffer_count;
+    unsigned                  buf_tail; //tail of buffer ring which is not published yet
+
+    ll_uring_device_t* devices;
+    size_t             devices_count;
+    size_t             devices_max;
+} ll_uring_t;
+
+
+/**
+ * @brief This function creates io_uring instance and ring of provided buffers.
+ * @param uring uring,
+ * if uring == NULL then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param devices_max maximal quantity of devices
+ * @param buffer_count quantity of provided buffers, it must be a power of two
+ * not bigger than 32768
+ * @param buffer_size size of every provided buffer
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (also if io_uring is not supported
+ * or memory can't be allocated, errno is set in this case)
+ */
+ll_status_t ll_uring_init(ll_uring_t* uring, size_t devices_max, size_t buffer_count, size_t buffer_size);
+
+/**
+ * @brief This function destroys io_uring instance and frees memory. File descriptors
+ * of devices are not closed.
+ * @param uring uring,
+ * if uring == NULL then function does nothing
+ */
+void ll_uring_destroy(ll_uring_t* uring);
+
+/**
+ * @brief This function adds device which will be read by ll_uring_run.
+ * @param uring uring
+ * @param fd file descriptor of device
+ * @param msg_info message info of byte stream of device
+ * @param buffer area of memory with size of msg_info.size where parsed message will be putted
+ * @param device pointer where index of device will be putted
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS (if there are already devices_max
+ * devices or arguments are bad)
+ */
+ll_status_t ll_uring_add(ll_uring_t* uring, int fd, ll_message_info_t msg_info, uint8_t* buffer, size_t* device);
+
+/**
+ * @brief This function sets tracker which records latencies of messages of device
+ * (see ll_latency.h), timestamps are taken by decoder of device when "begin byte"
+ * is parsed and when message is parsed.
+ * @param uring uring
+ * @param device index of device returned by ll_uring_add,
+ * if it is not valid then function does nothing and returns LL_STATUS_BAD_PARAMS
+ * @param tracker tracker, NULL disables tracking
+ * @returns LL_STATUS_SUCCESS or LL_STATUS_BAD_PARAMS
+ */
+ll_status_t ll_uring_trace(ll_uring_t* uring, size_t device, ll_latency_tracker_t* tracker);
+
+/**
+ * @brief This function submits read requests, waits for at least one completion,
+ * parses bytes of all ready completions and calls callback for every parsed message.
+ * @param uring uring
+ * @param callback callback,
+ * if callback == NULL then function does nothing and returns -EINVAL
+ * @param context context passed to "callback"
+ * @returns quantity of processed completions, 0 if all devices are closed,
+ * negative errno if io_uring_enter failed
+ */
+int ll_uring_run(ll_uring_t* uring, ll_uring_callback_t callback, void* context);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // LL_URING_H
@@ -0,0 +1,188 @@
+/*
+    Round trip of capture file: chunks are written, segment is torn as if program
+stopped during fwrite, file is opened for appending again and all chunks which were
+written completely must be read back in order.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ll_capture.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LL_CAPTURE_TEST_PATH "ll_capture_test.cap"
+#define LL_CAPTURE_TEST_CHUNKS 64
+
+
+static int failures = 0;
+
+static void ll_capture_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+//chunk "index" has size and bytes which depend on index
+static size_t ll_capture_test_chunk(size_t index, uint8_t* chunk)
+{
+    size_t size = 1 + index * 37 % 200;
+    for(size_t i = 0; i < size; i++)
+    {
+        chunk[i] = (uint8_t)(index * 31 + i);
+    }
+    return size;
+}
+
+//appends chunks [begin, end) and writes them as one segment
+static void ll_capture_test_write(size_t begin, size_t end)
+{
+    ll_capture_writer_t writer;
+    ll_capture_test_check(ll_capture_writer_open(&writer, LL_CAPTURE_TEST_PATH) == LL_STATUS_SUCCESS,
+                          "writer is opened");
+    uint8_t chunk[256];
+    for(size_t i = begin; i < end; i++)
+    {
+        size_t size = ll_capture_test_chunk(i, chunk);
+        ll_capture_append(&writer, 1000 * i, chunk, size);
+    }
+    ll_capture_test_check(ll_capture_writer_close(&writer) == LL_STATUS_SUCCESS, "writer is closed");
+}
+
+//appends first "size" bytes of segment, like program which stopped during fwrite
+static void ll_capture_test_tear(size_t size)
+{
+    uint8_t torn[64];
+    memset(torn, 0x5A, sizeof(torn));
+    memcpy(torn, "LLSG", 4);
+    //sizes of records and stored data are bigger than written bytes
+    torn[4] = 200;
+    torn[8] = 200;
+
+    FILE* file = fopen(LL_CAPTURE_TEST_PATH, "ab");
+    ll_capture_test_check(file && fwrite(torn, 1, size, file) == size, "torn segment is written");
+    if(file)
+    {
+        fclose(file);
+    }
+}
+
+//flips bit of stored size of the first segment, flipping it again restores file
+static void ll_capture_test_corrupt(void)
+{
+    FILE* file = fopen(LL_CAPTURE_TEST_PATH, "r+b");
+    //magic of file (8 bytes), magic and size of records of segment (8 bytes)
+    int byte = file && fseek(file, 16, SEEK_SET) == 0 ? fgetc(file) : EOF;
+    ll_capture_test_check(   byte != EOF
+                          && fseek(file, 16, SEEK_SET) == 0
+                          && fputc(byte ^ 1, file) != EOF,
+                          "segment is corrupted");
+    if(file)
+    {
+        fclose(file);
+    }
+}
+
+//reads all chunks and checks that they are chunks [0, count)
+static void ll_capture_test_read(size_t count, const char* what)
+{
+    ll_capture_reader_t reader;
+    if(ll_capture_reader_open(&reader, LL_CAPTURE_TEST_PATH) != LL_STATUS_SUCCESS)
+    {
+        ll_capture_test_check(false, what);
+        return;
+    }
+
+    uint8_t expected[256];
+    size_t chunks = 0;
+    uint64_t timestamp;
+    const uint8_t* data;
+    size_t size;
+    ll_status_t status;
+    while((status = ll_capture_next(&reader, &timestamp, &data, &size)) == LL_STATUS_SUCCESS)
+    {
+        size_t expected_size = ll_capture_test_chunk(chunks, expected);
+        if(   chunks >= count
+           || size != expected_size
+           || memcmp(data, expected, size) != 0
+           || timestamp != 1000 * chunks)
+        {
+            break;
+        }
+        chunks++;
+    }
+    ll_capture_test_check(status == LL_STATUS_NO_MESSAGE && chunks == count, what);
+    ll_capture_reader_close(&reader);
+}
+
+int main(void)
+{
+    unlink(LL_CAPTURE_TEST_PATH);
+
+    ll_capture_test_write(0, LL_CAPTURE_TEST_CHUNKS);
+    ll_capture_test_read(LL_CAPTURE_TEST_CHUNKS, "chunks of new file are read");
+
+    //stored data of segment is torn
+    ll_capture_test_tear(40);
+    ll_capture_test_write(LL_CAPTURE_TEST_CHUNKS, 2 * LL_CAPTURE_TEST_CHUNKS);
+    ll_capture_test_read(2 * LL_CAPTURE_TEST_CHUNKS, "chunks are appended after torn segment");
+
+    //header of segment is torn
+    ll_capture_test_tear(10);
+    ll_capture_test_write(2 * LL_CAPTURE_TEST_CHUNKS, 3 * LL_CAPTURE_TEST_CHUNKS);
+    ll_capture_test_read(3 * LL_CAPTURE_TEST_CHUNKS, "chunks are appended after torn header");
+
+    //magic of file is torn
+    unlink(LL_CAPTURE_TEST_PATH);
+    FILE* file = fopen(LL_CAPTURE_TEST_PATH, "wb");
+    ll_capture_test_check(file && fwrite("LLCAP", 1, 5, file) == 5, "torn magic is written");
+    if(file)
+    {
+        fclose(file);
+    }
+    ll_capture_test_write(0, LL_CAPTURE_TEST_CHUNKS);
+    ll_capture_test_read(LL_CAPTURE_TEST_CHUNKS, "chunks are appended after torn magic");
+
+    //segment in the middle of file is corrupted, complete segments after it are not cut off
+    ll_capture_test_write(LL_CAPTURE_TEST_CHUNKS, 2 * LL_CAPTURE_TEST_CHUNKS);
+    ll_capture_test_corrupt();
+    ll_capture_writer_t corrupted;
+    ll_capture_test_check(ll_capture_writer_open(&corrupted, LL_CAPTURE_TEST_PATH) == LL_STATUS_BAD_PARAMS,
+                          "file with corrupted segment is not opened");
+    ll_capture_test_corrupt();
+    ll_capture_test_read(2 * LL_CAPTURE_TEST_CHUNKS, "segments after corrupted one are not cut off");
+
+    //file which is not capture file is not changed
+    file = fopen(LL_CAPTURE_TEST_PATH, "wb");
+    ll_capture_test_check(file && fwrite("not capture", 1, 11, file) == 11, "other file is written");
+    if(file)
+    {
+        fclose(file);
+    }
+    ll_capture_writer_t writer;
+    ll_capture_test_check(ll_capture_writer_open(&writer, LL_CAPTURE_TEST_PATH) == LL_STATUS_BAD_PARAMS,
+                          "other file is not opened");
+    file = fopen(LL_CAPTURE_TEST_PATH, "rb");
+    char content[16] = {0};
+    ll_capture_test_check(file && fread(content, 1, sizeof(content), file) == 11
+                          && memcmp(content, "not capture", 11) == 0,
+                          "other file is not changed");
+    if(file)
+    {
+        fclose(file);
+    }
+
+    unlink(LL_CAPTURE_TEST_PATH);
+    if(failures)
+    {
+        return 1;
+    }
+    printf("ll_capture_test: OK\n");
+    return 0;
+}
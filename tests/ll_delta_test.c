@@ -0,0 +1,261 @@
+/*
+    Delta mode: receiver must get back every message whose frame is received while it has
+reference, deltas after lost frame must be rejected with LL_STATUS_NO_REFERENCE until the
+next keyframe (also after 256 lost frames), and on noisy stream with checksum only sent
+messages can be received. Messages of size 0 and keyframe interval 1 are also checked.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_delta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_DELTA_TEST_FRAMES 300
+#define LL_DELTA_TEST_NOISY_FRAMES 2000
+#define LL_DELTA_TEST_NOISY_SIZE 40
+
+
+static int failures = 0;
+static uint64_t random_state = 17;
+
+static void ll_delta_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_delta_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+//every fourth byte is control byte or byte near them
+static uint8_t ll_delta_test_byte(void)
+{
+    return ll_delta_test_random() % 4 ? (uint8_t)ll_delta_test_random()
+                                      : (uint8_t)(0x7C + ll_delta_test_random() % 4);
+}
+
+static ll_message_info_t ll_delta_test_info(size_t size, int framing, int checksum)
+{
+    ll_message_info_t msg_info;
+    memset(&msg_info, 0, sizeof(msg_info));
+    msg_info.size = size;
+    msg_info.begin_byte = 0x7E;
+    msg_info.reject_byte = 0x7D;
+    msg_info.end_byte = framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+    msg_info.framing = (ll_framing_t)framing;
+    msg_info.checksum = (ll_checksum_t)checksum;
+    return msg_info;
+}
+
+//few bytes are changed, sometimes many of them
+static void ll_delta_test_change(uint8_t* message, size_t size)
+{
+    uint32_t changes = ll_delta_test_random() % 5 == 0 ? ll_delta_test_random() % (uint32_t)(size + 1)
+                                                       : ll_delta_test_random() % 4;
+    for(uint32_t i = 0; i < changes && size > 0; i++)
+    {
+        message[ll_delta_test_random() % size] = ll_delta_test_byte();
+    }
+}
+
+static void ll_delta_test_round_trip(ll_message_info_t msg_info, uint64_t keyframe_interval)
+{
+    ll_delta_encoder_t encoder;
+    ll_delta_decoder_t decoder;
+    if(   ll_delta_encoder_init(&encoder, msg_info, keyframe_interval) != LL_STATUS_SUCCESS
+       || ll_delta_decoder_init(&decoder, msg_info) != LL_STATUS_SUCCESS)
+    {
+        ll_delta_test_check(false, "encoder and decoder are initialized");
+        return;
+    }
+
+    size_t frame_max = ll_sizeof_delta_max(msg_info);
+    uint8_t* message = calloc(msg_info.size + 1, 1);
+    uint8_t* received = malloc(msg_info.size + 1);
+    uint8_t* stream = malloc(frame_max + 4);
+    //receiver has reference if no frame was lost after the last received keyframe
+    bool has_reference = false;
+    for(int i = 0; i < LL_DELTA_TEST_FRAMES; i++)
+    {
+        ll_delta_test_change(message, msg_info.size);
+        uint64_t keyframes = encoder.keyframes;
+        //bytes before frame are not "begin byte"
+        size_t noise = ll_delta_test_random() % 4;
+        for(size_t j = 0; j < noise; j++)
+        {
+            stream[j] = (uint8_t)(ll_delta_test_random() % 0x7C);
+        }
+        size_t frame_size = ll_delta_serialize(&encoder, message, stream + noise);
+        bool keyframe = encoder.keyframes != keyframes;
+        ll_delta_test_check(frame_size > 0 && frame_size <= frame_max, "frame fits into maximal size");
+
+        if(ll_delta_test_random() % 20 == 0)
+        {
+            has_reference = false;
+            continue;
+        }
+        size_t remainder = 1;
+        ll_delta_test_check(   ll_delta_deserialize(&decoder, stream, noise + frame_size - 1, received, &remainder)
+                            == LL_STATUS_NO_ENOUGH_BYTES
+                            && remainder == noise,
+                            "frame without \"end byte\" is not completed");
+
+        memset(received, 0xEE, msg_info.size);
+        ll_status_t status = ll_delta_deserialize(&decoder, stream, noise + frame_size, received, &remainder);
+        if(keyframe || has_reference)
+        {
+            ll_delta_test_check(   status == LL_STATUS_SUCCESS
+                                && remainder == 0
+                                && memcmp(received, message, msg_info.size) == 0,
+                                "message is received");
+            has_reference = true;
+        }
+        else
+        {
+            ll_delta_test_check(status == LL_STATUS_NO_REFERENCE, "delta after lost frame is rejected");
+        }
+    }
+
+    ll_delta_encoder_destroy(&encoder);
+    ll_delta_decoder_destroy(&decoder);
+    free(message);
+    free(received);
+    free(stream);
+}
+
+//sequence number must not wrap after 256 lost frames
+static void ll_delta_test_many_lost(void)
+{
+    ll_message_info_t msg_info = ll_delta_test_info(16, LL_FRAMING_XOR, LL_CHECKSUM_NONE);
+    ll_delta_encoder_t encoder;
+    ll_delta_decoder_t decoder;
+    ll_delta_encoder_init(&encoder, msg_info, 100000);
+    ll_delta_decoder_init(&decoder, msg_info);
+    uint8_t message[16] = {0};
+    uint8_t received[16];
+    uint8_t frame[64];
+    size_t remainder;
+
+    size_t frame_size = ll_delta_serialize(&encoder, message, frame);
+    ll_delta_test_check(ll_delta_deserialize(&decoder, frame, frame_size, received, &remainder)
+                        == LL_STATUS_SUCCESS, "keyframe is received");
+    for(int i = 0; i < 256; i++)
+    {
+        message[1]++;
+        ll_delta_serialize(&encoder, message, frame);
+    }
+    message[2] = 9;
+    frame_size = ll_delta_serialize(&encoder, message, frame);
+    ll_delta_test_check(ll_delta_deserialize(&decoder, frame, frame_size, received, &remainder)
+                        == LL_STATUS_NO_REFERENCE, "delta after 256 lost frames is rejected");
+
+    ll_delta_encoder_destroy(&encoder);
+    ll_delta_decoder_destroy(&decoder);
+}
+
+//frames are written one after another and bits are flipped
+static void ll_delta_test_noisy(ll_message_info_t msg_info)
+{
+    ll_delta_encoder_t encoder;
+    ll_delta_decoder_t decoder;
+    ll_delta_encoder_init(&encoder, msg_info, 16);
+    ll_delta_decoder_init(&decoder, msg_info);
+    uint8_t* messages = malloc(LL_DELTA_TEST_NOISY_FRAMES * msg_info.size);
+    uint8_t* stream = malloc(LL_DELTA_TEST_NOISY_FRAMES * ll_sizeof_delta_max(msg_info));
+    uint8_t message[LL_DELTA_TEST_NOISY_SIZE] = {0};
+    uint8_t received[LL_DELTA_TEST_NOISY_SIZE];
+    size_t size = 0;
+    for(size_t i = 0; i < LL_DELTA_TEST_NOISY_FRAMES; i++)
+    {
+        ll_delta_test_change(message, msg_info.size);
+        memcpy(messages + i * msg_info.size, message, msg_info.size);
+        size += ll_delta_serialize(&encoder, message, stream + size);
+    }
+    for(size_t i = 0; i < size / 300; i++)
+    {
+        stream[ll_delta_test_random() % size] ^= (uint8_t)(1u << (ll_delta_test_random() % 8));
+    }
+
+    size_t position = 0;
+    size_t next = 0;
+    while(position < size)
+    {
+        size_t remainder = 0;
+        ll_status_t status = ll_delta_deserialize(&decoder, stream + position, size - position, received, &remainder);
+        if(status == LL_STATUS_SUCCESS)
+        {
+            //messages are received in order, some of them can be lost
+            size_t found = next;
+            while(found < LL_DELTA_TEST_NOISY_FRAMES && memcmp(messages + found * msg_info.size, received, msg_info.size))
+            {
+                found++;
+            }
+            ll_delta_test_check(found < LL_DELTA_TEST_NOISY_FRAMES, "only sent messages are received");
+            next = found < LL_DELTA_TEST_NOISY_FRAMES ? found + 1 : next;
+        }
+        if(status == LL_STATUS_NO_ENOUGH_BYTES || status == LL_STATUS_NO_MESSAGE || remainder == 0)
+        {
+            break;
+        }
+        position += remainder;
+    }
+    ll_delta_test_check(next > LL_DELTA_TEST_NOISY_FRAMES / 2, "most of messages are received");
+
+    ll_delta_encoder_destroy(&encoder);
+    ll_delta_decoder_destroy(&decoder);
+    free(messages);
+    free(stream);
+}
+
+int main(void)
+{
+    const size_t sizes[] = {0, 1, 7, 64, 300, 1000};
+    const uint64_t intervals[] = {1, 8, 1000};
+    const int framings[] = {LL_FRAMING_REJECT, LL_FRAMING_XOR};
+    for(size_t framing = 0; framing < sizeof(framings) / sizeof(framings[0]); framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+            {
+                for(size_t j = 0; j < sizeof(intervals) / sizeof(intervals[0]); j++)
+                {
+                    ll_delta_test_round_trip(ll_delta_test_info(sizes[i], framings[framing], checksum),
+                                             intervals[j]);
+                }
+            }
+        }
+        ll_delta_test_noisy(ll_delta_test_info(LL_DELTA_TEST_NOISY_SIZE, framings[framing], LL_CHECKSUM_CRC32C));
+    }
+    ll_delta_test_many_lost();
+
+    ll_delta_encoder_t encoder;
+    ll_delta_test_check(   ll_delta_encoder_init(&encoder, ll_delta_test_info(8, LL_FRAMING_XOR, LL_CHECKSUM_NONE), 0)
+                        == LL_STATUS_BAD_PARAMS, "keyframe interval 0 is rejected");
+    ll_delta_test_check(   ll_delta_encoder_init(&encoder, ll_delta_test_info(8, LL_FRAMING_COBS, LL_CHECKSUM_NONE), 16)
+                        == LL_STATUS_BAD_PARAMS
+                        && ll_sizeof_delta_max(ll_delta_test_info(8, LL_FRAMING_COBS, LL_CHECKSUM_NONE)) == 0,
+                        "COBS framing is rejected");
+
+    if(failures)
+    {
+        fprintf(stderr, "ll_delta_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_delta_test: OK\n");
+    return 0;
+}
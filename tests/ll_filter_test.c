@@ -0,0 +1,216 @@
+/*
+    Filtered deserialization: ll_deserialize_filtered must return the same statuses and
+remainders as ll_deserialize on noisy streams, write matched messages completely and
+write only checked first bytes of messages which are not matched.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_FILTER_TEST_STREAM 20000
+#define LL_FILTER_TEST_SENTINEL 0xEE
+
+
+static int failures = 0;
+static uint64_t random_state = 3;
+
+static void ll_filter_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_filter_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+//third byte of header is checked, so the whole header is needed
+static bool ll_filter_test_predicate(void* context, const uint8_t* header, size_t header_size)
+{
+    (void)context;
+    return header_size >= 3 && (header[2] & 3) == 1;
+}
+
+static bool ll_filter_test_wanted(const ll_filter_t* filter, const uint8_t* message)
+{
+    if(filter->predicate)
+    {
+        return filter->predicate(filter->context, message, filter->header_size);
+    }
+    return (filter->first_bytes[message[0] >> 3] >> (message[0] & 7)) & 1;
+}
+
+//stream of frames, cut frames and control bytes, some bits are flipped
+static size_t ll_filter_test_stream(ll_message_info_t msg_info, uint8_t* stream, size_t capacity)
+{
+    uint8_t* message = malloc(msg_info.size + 1);
+    uint8_t* frame = malloc(ll_sizeof_serialized_max(msg_info));
+    size_t size = 0;
+    while(size + ll_sizeof_serialized_max(msg_info) + 8 < capacity)
+    {
+        for(size_t i = 0; i < msg_info.size; i++)
+        {
+            message[i] = ll_filter_test_random() % 4 == 0 ? (uint8_t)(0x7C + ll_filter_test_random() % 4)
+                                                          : (uint8_t)ll_filter_test_random();
+        }
+        size_t frame_size = ll_serialize(msg_info, message, frame);
+        if(ll_filter_test_random() % 5 == 0)
+        {
+            frame_size = ll_filter_test_random() % (frame_size + 1);
+        }
+        memcpy(stream + size, frame, frame_size);
+        size += frame_size;
+        for(uint32_t noise = ll_filter_test_random() % 6; noise > 0; noise--)
+        {
+            stream[size++] = (uint8_t)(0x7C + ll_filter_test_random() % 4);
+        }
+    }
+    for(int i = 0; i < 20 && size > 0; i++)
+    {
+        stream[ll_filter_test_random() % size] ^= (uint8_t)(1u << (ll_filter_test_random() % 8));
+    }
+    free(message);
+    free(frame);
+    return size;
+}
+
+static void ll_filter_test_stream_equivalence(void)
+{
+    uint8_t* stream = malloc(LL_FILTER_TEST_STREAM);
+    for(int iteration = 0; iteration < 300; iteration++)
+    {
+        ll_message_info_t msg_info;
+        memset(&msg_info, 0, sizeof(msg_info));
+        msg_info.size = 3 + ll_filter_test_random() % 300;
+        msg_info.begin_byte = 0x7E;
+        msg_info.reject_byte = 0x7D;
+        msg_info.end_byte = iteration % 2 ? 0x7F : 0x7E;
+        msg_info.framing = (ll_framing_t)(ll_filter_test_random() % LL_FRAMING_ENUM_SIZE);
+        msg_info.checksum = (ll_checksum_t)(ll_filter_test_random() % LL_CHECKSUM_ENUM_SIZE);
+        if(msg_info.framing == LL_FRAMING_REJECT)
+        {
+            msg_info.end_byte = 0x7C;
+        }
+
+        ll_filter_t filter;
+        memset(&filter, 0, sizeof(filter));
+        if(iteration % 2)
+        {
+            filter.predicate = ll_filter_test_predicate;
+            filter.header_size = 3;
+        }
+        else
+        {
+            for(int i = 0; i < 128; i++)
+            {
+                ll_filter_add_first_byte(&filter, (uint8_t)ll_filter_test_random());
+            }
+        }
+
+        size_t size = ll_filter_test_stream(msg_info, stream, LL_FILTER_TEST_STREAM);
+        uint8_t* expected = malloc(msg_info.size);
+        uint8_t* filtered = malloc(msg_info.size);
+        size_t position = 0;
+        for(;;)
+        {
+            size_t expected_remainder = 0;
+            size_t filtered_remainder = 0;
+            bool matched = false;
+            memset(filtered, LL_FILTER_TEST_SENTINEL, msg_info.size);
+            ll_status_t expected_status = ll_deserialize(msg_info, stream + position, size - position,
+                                                         expected, &expected_remainder);
+            ll_status_t filtered_status = ll_deserialize_filtered(msg_info, &filter, stream + position,
+                                                                  size - position, filtered, &matched,
+                                                                  &filtered_remainder);
+            ll_filter_test_check(   expected_status == filtered_status
+                                 && expected_remainder == filtered_remainder,
+                                 "filtered status and remainder are the same as unfiltered");
+
+            if(expected_status == LL_STATUS_SUCCESS || expected_status == LL_STATUS_CHECKSUM_FAILURE)
+            {
+                ll_filter_test_check(matched == ll_filter_test_wanted(&filter, expected),
+                                     "message is matched by filter");
+                if(matched)
+                {
+                    ll_filter_test_check(memcmp(expected, filtered, msg_info.size) == 0,
+                                         "matched message is written");
+                }
+                else
+                {
+                    size_t checked = filter.predicate ? filter.header_size : 1;
+                    bool untouched = true;
+                    for(size_t i = checked; i < msg_info.size; i++)
+                    {
+                        untouched = untouched && filtered[i] == LL_FILTER_TEST_SENTINEL;
+                    }
+                    ll_filter_test_check(untouched, "only header of not matched message is written");
+                }
+            }
+            if(   expected_status == LL_STATUS_NO_MESSAGE
+               || expected_status == LL_STATUS_NO_ENOUGH_BYTES
+               || expected_remainder == 0)
+            {
+                break;
+            }
+            position += expected_remainder;
+        }
+        free(expected);
+        free(filtered);
+    }
+    free(stream);
+}
+
+static void ll_filter_test_bad_params(void)
+{
+    ll_message_info_t msg_info;
+    memset(&msg_info, 0, sizeof(msg_info));
+    msg_info.begin_byte = 0x7E;
+    msg_info.reject_byte = 0x7D;
+    msg_info.end_byte = 0x7C;
+    msg_info.checksum = LL_CHECKSUM_CRC32C;
+    uint8_t data[1] = {0};
+    uint8_t frame[16];
+    size_t frame_size = ll_serialize(msg_info, data, frame);
+    bool matched;
+    size_t remainder;
+
+    //message of size 0 has no first byte
+    ll_filter_t filter;
+    memset(&filter, 0, sizeof(filter));
+    ll_filter_add_first_byte(&filter, 0);
+    ll_filter_test_check(ll_deserialize_filtered(msg_info, &filter, frame, frame_size, data, &matched, &remainder)
+                         == LL_STATUS_BAD_PARAMS, "first byte filter of empty message is rejected");
+
+    filter.predicate = ll_filter_test_predicate;
+    filter.header_size = 1;
+    ll_filter_test_check(ll_deserialize_filtered(msg_info, &filter, frame, frame_size, data, &matched, &remainder)
+                         == LL_STATUS_BAD_PARAMS, "header bigger than message is rejected");
+}
+
+int main(void)
+{
+    ll_filter_test_stream_equivalence();
+    ll_filter_test_bad_params();
+    if(failures)
+    {
+        fprintf(stderr, "ll_filter_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_filter_test: OK\n");
+    return 0;
+}
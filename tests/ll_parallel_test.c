@@ -0,0 +1,184 @@
+/*
+    Parallel parsing and serializing: ll_deserialize_parallel must call callback with the
+same results in the same order as ll_deserialize_all on clean, damaged and cut streams
+of several chunks, and ll_serialize_parallel must write the same bytes as ll_serialize.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_PARALLEL_TEST_STREAM ((size_t)3 * 1024 * 1024)
+#define LL_PARALLEL_TEST_MESSAGE ((size_t)3 * 1024 * 1024)
+
+
+static int failures = 0;
+static uint64_t random_state = 11;
+
+typedef struct
+{
+    size_t   size;   //message size
+    size_t   count;  //quantity of results
+    uint64_t hash;   //hash of statuses, positions and messages
+} ll_parallel_test_results_t;
+
+static void ll_parallel_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_parallel_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+//every fourth byte is control byte or byte near them
+static uint8_t ll_parallel_test_byte(void)
+{
+    return ll_parallel_test_random() % 4 ? (uint8_t)ll_parallel_test_random()
+                                         : (uint8_t)(0x7C + ll_parallel_test_random() % 4);
+}
+
+static void ll_parallel_test_collect(void* context, ll_status_t status, size_t position, const uint8_t* data)
+{
+    ll_parallel_test_results_t* results = context;
+    results->count++;
+    results->hash = (results->hash ^ (uint64_t)status) * 1099511628211u;
+    results->hash = (results->hash ^ (uint64_t)position) * 1099511628211u;
+    for(size_t i = 0; data && i < results->size; i++)
+    {
+        results->hash = (results->hash ^ data[i]) * 1099511628211u;
+    }
+}
+
+//"damage" 0 - clean stream, 1 - some bytes are replaced by control bytes, 2 - also frames are cut
+static size_t ll_parallel_test_stream(ll_message_info_t msg_info, int damage, uint8_t* stream, size_t capacity)
+{
+    uint8_t* message = malloc(msg_info.size + 1);
+    uint8_t* frame = malloc(ll_sizeof_serialized_max(msg_info));
+    size_t size = 0;
+    while(size + ll_sizeof_serialized_max(msg_info) < capacity)
+    {
+        for(size_t i = 0; i < msg_info.size; i++)
+        {
+            message[i] = ll_parallel_test_byte();
+        }
+        size_t frame_size = ll_serialize(msg_info, message, frame);
+        if(damage > 0 && ll_parallel_test_random() % (damage == 1 ? 50 : 3) == 0)
+        {
+            frame[ll_parallel_test_random() % frame_size] = (uint8_t)(0x7C + ll_parallel_test_random() % 4);
+        }
+        if(damage == 2 && ll_parallel_test_random() % 5 == 0)
+        {
+            frame_size = ll_parallel_test_random() % (frame_size + 1);
+        }
+        memcpy(stream + size, frame, frame_size);
+        size += frame_size;
+    }
+    free(message);
+    free(frame);
+    return size;
+}
+
+static void ll_parallel_test_deserialize(uint8_t* stream)
+{
+    for(int framing = 0; framing < LL_FRAMING_ENUM_SIZE; framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            for(int damage = 0; damage < 3; damage++)
+            {
+                ll_message_info_t msg_info;
+                memset(&msg_info, 0, sizeof(msg_info));
+                msg_info.size = damage == 0 && checksum == 0 ? ll_parallel_test_random() % 4
+                                                             : 3 + ll_parallel_test_random() % 60;
+                msg_info.begin_byte = 0x7E;
+                msg_info.reject_byte = 0x7D;
+                msg_info.end_byte = framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+                msg_info.framing = (ll_framing_t)framing;
+                msg_info.checksum = (ll_checksum_t)checksum;
+
+                size_t size = ll_parallel_test_stream(msg_info, damage, stream, LL_PARALLEL_TEST_STREAM);
+                ll_parallel_test_results_t expected = { msg_info.size, 0, 0 };
+                ll_parallel_test_results_t parallel = { msg_info.size, 0, 0 };
+                size_t expected_remainder = 0;
+                size_t parallel_remainder = 0;
+                ll_status_t expected_status = ll_deserialize_all(msg_info, stream, size, ll_parallel_test_collect,
+                                                                 &expected, &expected_remainder);
+                ll_status_t parallel_status = ll_deserialize_parallel(msg_info, stream, size,
+                                                                      2 + ll_parallel_test_random() % 6,
+                                                                      ll_parallel_test_collect, &parallel,
+                                                                      &parallel_remainder);
+                ll_parallel_test_check(   expected_status == parallel_status
+                                       && expected_remainder == parallel_remainder
+                                       && expected.count == parallel.count
+                                       && expected.hash == parallel.hash,
+                                       "parallel results are the same as sequential");
+            }
+        }
+    }
+}
+
+static void ll_parallel_test_serialize(void)
+{
+    uint8_t* message = malloc(LL_PARALLEL_TEST_MESSAGE);
+    for(int iteration = 0; iteration < 12; iteration++)
+    {
+        ll_message_info_t msg_info;
+        memset(&msg_info, 0, sizeof(msg_info));
+        msg_info.size = iteration < 2 ? (size_t)iteration : ll_parallel_test_random() % LL_PARALLEL_TEST_MESSAGE;
+        msg_info.begin_byte = 0x7E;
+        msg_info.reject_byte = 0x7D;
+        msg_info.framing = (ll_framing_t)(iteration % LL_FRAMING_ENUM_SIZE);
+        msg_info.end_byte = msg_info.framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+        msg_info.checksum = (ll_checksum_t)(iteration / LL_FRAMING_ENUM_SIZE % LL_CHECKSUM_ENUM_SIZE);
+        for(size_t i = 0; i < msg_info.size; i++)
+        {
+            message[i] = ll_parallel_test_byte();
+        }
+
+        size_t frame_size = ll_sizeof_serialized_max(msg_info) + 1;
+        uint8_t* expected = malloc(frame_size);
+        uint8_t* parallel = malloc(frame_size);
+        memset(expected, 0xEE, frame_size);
+        memset(parallel, 0xEE, frame_size);
+        size_t expected_size = ll_serialize(msg_info, message, expected);
+        size_t parallel_size = ll_serialize_parallel(msg_info, message, parallel, 1 + ll_parallel_test_random() % 8);
+        ll_parallel_test_check(   expected_size == parallel_size
+                               && memcmp(expected, parallel, frame_size) == 0,
+                               "parallel frame is the same as sequential");
+        free(expected);
+        free(parallel);
+    }
+    free(message);
+}
+
+int main(void)
+{
+    uint8_t* stream = malloc(LL_PARALLEL_TEST_STREAM);
+    ll_parallel_test_deserialize(stream);
+    free(stream);
+    ll_parallel_test_serialize();
+
+    if(failures)
+    {
+        fprintf(stderr, "ll_parallel_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_parallel_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+    Patched frame: after every ll_patch_update frame must be the same as frame
+serialized from the whole changed message, in all framings, with and without
+checksum, for messages of size 0 and sizes around words of escape map.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_patch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_PATCH_TEST_UPDATES 1000
+
+
+static int failures = 0;
+static uint64_t random_state = 9;
+
+static void ll_patch_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_patch_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+//every third byte is control byte or byte near them
+static uint8_t ll_patch_test_byte(void)
+{
+    return ll_patch_test_random() % 3 ? (uint8_t)ll_patch_test_random()
+                                      : (uint8_t)(0x7C + ll_patch_test_random() % 4);
+}
+
+static void ll_patch_test_message(ll_message_info_t msg_info)
+{
+    uint8_t* message = malloc(msg_info.size + 1);
+    uint8_t* change = malloc(msg_info.size + 1);
+    uint8_t* expected = malloc(ll_sizeof_serialized_max(msg_info));
+    for(size_t i = 0; i < msg_info.size; i++)
+    {
+        message[i] = ll_patch_test_byte();
+    }
+
+    ll_patch_t patch;
+    if(ll_patch_init(&patch, msg_info, message) != LL_STATUS_SUCCESS)
+    {
+        ll_patch_test_check(false, "patch is initialized");
+        free(message);
+        free(change);
+        free(expected);
+        return;
+    }
+    size_t expected_size = ll_serialize(msg_info, message, expected);
+    ll_patch_test_check(   patch.frame_size == expected_size
+                        && memcmp(patch.frame, expected, expected_size) == 0,
+                        "initial frame is serialized message");
+
+    for(int update = 0; update < LL_PATCH_TEST_UPDATES; update++)
+    {
+        //mostly short changes, sometimes the whole tail of message
+        size_t offset = msg_info.size ? ll_patch_test_random() % msg_info.size : 0;
+        size_t left = msg_info.size - offset;
+        size_t size = update % 10 == 0 || left < 16 ? left : 1 + ll_patch_test_random() % 16;
+        if(left)
+        {
+            size = 1 + ll_patch_test_random() % size;
+        }
+        for(size_t i = 0; i < size; i++)
+        {
+            change[i] = ll_patch_test_random() % 4 ? ll_patch_test_byte() : message[offset + i];
+        }
+        memcpy(message + offset, change, size);
+
+        ll_patch_test_check(ll_patch_update(&patch, offset, change, size) == LL_STATUS_SUCCESS,
+                            "patch is updated");
+        expected_size = ll_serialize(msg_info, message, expected);
+        if(patch.frame_size != expected_size || memcmp(patch.frame, expected, expected_size) != 0)
+        {
+            ll_patch_test_check(false, "updated frame is serialized message");
+            break;
+        }
+    }
+
+    ll_patch_test_check(ll_patch_update(&patch, msg_info.size, change, 1) == LL_STATUS_BAD_PARAMS,
+                        "update after the end of message is rejected");
+    ll_patch_destroy(&patch);
+    free(message);
+    free(change);
+    free(expected);
+}
+
+int main(void)
+{
+    const size_t sizes[] = {0, 1, 2, 7, 60, 63, 64, 65, 127, 128, 300, 1000, 5000};
+    for(int framing = 0; framing < LL_FRAMING_ENUM_SIZE; framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+            {
+                ll_message_info_t msg_info;
+                memset(&msg_info, 0, sizeof(msg_info));
+                msg_info.size = sizes[i];
+                msg_info.begin_byte = 0x7E;
+                msg_info.reject_byte = 0x7D;
+                msg_info.end_byte = framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+                msg_info.framing = (ll_framing_t)framing;
+                msg_info.checksum = (ll_checksum_t)checksum;
+                ll_patch_test_message(msg_info);
+            }
+        }
+    }
+
+    if(failures)
+    {
+        fprintf(stderr, "ll_patch_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_patch_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,369 @@
+/*
+    Codecs of messages: every framing with and without checksum must give back serialized
+messages of any size (also 0 and sizes around COBS blocks). On noisy streams ll_scan and
+ll_deserialize_spans must return the same statuses and remainders as ll_deserialize,
+decoder must give every sent message and encoder must give the same bytes as ll_serialize.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_crc32c.h"
+#include "ll_protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_PROTOCOL_TEST_STREAM 20000
+#define LL_PROTOCOL_TEST_MESSAGES 200
+
+
+static int failures = 0;
+static uint64_t random_state = 5;
+
+static void ll_protocol_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_protocol_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+//every fourth byte is control byte or byte near them
+static uint8_t ll_protocol_test_byte(void)
+{
+    return ll_protocol_test_random() % 4 ? (uint8_t)ll_protocol_test_random()
+                                         : (uint8_t)(0x7C + ll_protocol_test_random() % 4);
+}
+
+static ll_message_info_t ll_protocol_test_info(size_t size, int framing, int checksum)
+{
+    ll_message_info_t msg_info;
+    memset(&msg_info, 0, sizeof(msg_info));
+    msg_info.size = size;
+    msg_info.begin_byte = 0x7E;
+    msg_info.reject_byte = 0x7D;
+    msg_info.end_byte = framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+    msg_info.framing = (ll_framing_t)framing;
+    msg_info.checksum = (ll_checksum_t)checksum;
+    return msg_info;
+}
+
+static void ll_protocol_test_crc32c(void)
+{
+    const uint8_t check[] = "123456789";
+    ll_protocol_test_check(ll_crc32c(0, check, 9) == 0xE3069283, "CRC32C of check string");
+    ll_protocol_test_check(ll_crc32c(0x12345678, check, 0) == 0x12345678, "CRC32C of empty data");
+
+    uint8_t zeros[32];
+    memset(zeros, 0, sizeof(zeros));
+    ll_protocol_test_check(ll_crc32c(0, zeros, sizeof(zeros)) == 0x8A9136AA, "CRC32C of zeros");
+
+    uint8_t data[3000];
+    for(size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)ll_protocol_test_random();
+    }
+    uint32_t whole = ll_crc32c(0, data, sizeof(data));
+    for(int i = 0; i < 100; i++)
+    {
+        //parts of every alignment
+        size_t split = ll_protocol_test_random() % (sizeof(data) + 1);
+        uint32_t first = ll_crc32c(0, data, split);
+        ll_protocol_test_check(ll_crc32c(first, data + split, sizeof(data) - split) == whole,
+                               "CRC32C is continued by parts");
+        ll_protocol_test_check(   ll_crc32c_combine(first, ll_crc32c(0, data + split, sizeof(data) - split),
+                                                    sizeof(data) - split)
+                               == whole, "CRC32C of parts is combined");
+    }
+}
+
+static void ll_protocol_test_round_trip(ll_message_info_t msg_info)
+{
+    uint8_t* message = malloc(msg_info.size + 1);
+    uint8_t* parsed = malloc(msg_info.size + 1);
+    uint8_t* frame = malloc(ll_sizeof_serialized_max(msg_info) + 1);
+    uint8_t* encoded = malloc(ll_sizeof_serialized_max(msg_info) + 1);
+    for(int iteration = 0; iteration < 20; iteration++)
+    {
+        for(size_t i = 0; i < msg_info.size; i++)
+        {
+            //message of only "end bytes" is the worst case of COBS
+            message[i] = iteration == 0 ? msg_info.end_byte
+                       : iteration == 1 ? (uint8_t)(msg_info.end_byte + 1)
+                       : ll_protocol_test_byte();
+        }
+        size_t frame_size = ll_serialize(msg_info, message, frame);
+        ll_protocol_test_check(   frame_size == ll_sizeof_serialized(msg_info, message)
+                               && frame_size <= ll_sizeof_serialized_max(msg_info),
+                               "size of frame is predicted");
+        ll_protocol_test_check(   frame[0] == msg_info.begin_byte
+                               && frame[frame_size - 1] == msg_info.end_byte,
+                               "frame is delimited");
+
+        size_t remainder = 1;
+        ll_protocol_test_check(   ll_deserialize(msg_info, frame, frame_size, parsed, &remainder)
+                               == LL_STATUS_SUCCESS
+                               && remainder == 0
+                               && memcmp(parsed, message, msg_info.size) == 0,
+                               "message is deserialized");
+        ll_protocol_test_check(   ll_deserialize(msg_info, frame, frame_size - 1, parsed, &remainder)
+                               == LL_STATUS_NO_ENOUGH_BYTES
+                               && remainder == 0,
+                               "frame without \"end byte\" is not completed");
+
+        ll_encoder_t encoder;
+        size_t encoded_size = 0;
+        uint8_t byte;
+        ll_protocol_test_check(ll_encoder_init(&encoder, msg_info, message) == LL_STATUS_SUCCESS,
+                               "encoder is initialized");
+        while(encoded_size <= frame_size && ll_encoder_next_byte(&encoder, &byte))
+        {
+            encoded[encoded_size++] = byte;
+        }
+        ll_protocol_test_check(   encoded_size == frame_size
+                               && memcmp(encoded, frame, frame_size) == 0
+                               && !ll_encoder_next_byte(&encoder, &byte),
+                               "encoder gives serialized frame");
+    }
+    free(message);
+    free(parsed);
+    free(frame);
+    free(encoded);
+}
+
+//stream of frames, cut frames and control bytes, some bits are flipped if "noisy"
+static size_t ll_protocol_test_stream(ll_message_info_t msg_info, bool noisy, uint8_t* stream,
+                                      uint8_t* messages, size_t* messages_count)
+{
+    uint8_t* frame = malloc(ll_sizeof_serialized_max(msg_info));
+    size_t size = 0;
+    *messages_count = 0;
+    while(   *messages_count < LL_PROTOCOL_TEST_MESSAGES
+          && size + ll_sizeof_serialized_max(msg_info) + 8 < LL_PROTOCOL_TEST_STREAM)
+    {
+        uint8_t* message = messages + *messages_count * msg_info.size;
+        for(size_t i = 0; i < msg_info.size; i++)
+        {
+            message[i] = ll_protocol_test_byte();
+        }
+        //cut frame is also kept in messages, because noise after it can be its "end byte"
+        size_t frame_size = ll_serialize(msg_info, message, frame);
+        if(noisy && ll_protocol_test_random() % 5 == 0)
+        {
+            frame_size = ll_protocol_test_random() % (frame_size + 1);
+        }
+        (*messages_count)++;
+        memcpy(stream + size, frame, frame_size);
+        size += frame_size;
+        //bytes between frames are not control bytes if stream is not noisy
+        for(uint32_t noise = ll_protocol_test_random() % 4; noise > 0; noise--)
+        {
+            stream[size++] = noisy ? (uint8_t)(0x7C + ll_protocol_test_random() % 4)
+                                   : (uint8_t)(ll_protocol_test_random() % 0x7C);
+        }
+    }
+    for(int i = 0; noisy && i < 20 && size > 0; i++)
+    {
+        stream[ll_protocol_test_random() % size] ^= (uint8_t)(1u << (ll_protocol_test_random() % 8));
+    }
+    free(frame);
+    return size;
+}
+
+//stream is split into spans at random positions, some spans are empty
+static size_t ll_protocol_test_spans(const uint8_t* stream, size_t size, ll_span_t* spans)
+{
+    size_t count = 1 + ll_protocol_test_random() % 4;
+    size_t position = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t span_size = i + 1 == count ? size - position : ll_protocol_test_random() % (size - position + 1);
+        spans[i].data = stream + position;
+        spans[i].size = span_size;
+        position += span_size;
+    }
+    return count;
+}
+
+static void ll_protocol_test_stream_equivalence(ll_message_info_t msg_info, uint8_t* stream,
+                                                uint8_t* messages)
+{
+    size_t messages_count;
+    size_t size = ll_protocol_test_stream(msg_info, true, stream, messages, &messages_count);
+    uint8_t* expected = malloc(msg_info.size + 1);
+    uint8_t* parsed = malloc(msg_info.size + 1);
+    size_t position = 0;
+    for(;;)
+    {
+        size_t expected_remainder = 0;
+        size_t scan_remainder = 0;
+        size_t spans_remainder = 0;
+        ll_frame_scan_t frame;
+        ll_span_t spans[4];
+        size_t spans_count = ll_protocol_test_spans(stream + position, size - position, spans);
+        ll_status_t expected_status = ll_deserialize(msg_info, stream + position, size - position,
+                                                     expected, &expected_remainder);
+        ll_status_t scan_status = ll_scan(msg_info, stream + position, size - position,
+                                          &frame, &scan_remainder);
+        ll_status_t spans_status = ll_deserialize_spans(msg_info, spans, spans_count,
+                                                        parsed, &spans_remainder);
+
+        ll_protocol_test_check(   expected_status == scan_status
+                               && expected_remainder == scan_remainder,
+                               "scan status and remainder are the same as deserialized");
+        ll_protocol_test_check(   expected_status == spans_status
+                               && expected_remainder == spans_remainder,
+                               "spans status and remainder are the same as contiguous");
+        if(expected_status == LL_STATUS_SUCCESS)
+        {
+            ll_protocol_test_check(   frame.size == msg_info.size + (msg_info.checksum ? 4 : 0)
+                                   && stream[position + frame.begin] == msg_info.begin_byte,
+                                   "scanned frame is found");
+            ll_protocol_test_check(memcmp(expected, parsed, msg_info.size) == 0,
+                                   "spans message is the same as contiguous");
+        }
+        if(   expected_status == LL_STATUS_NO_MESSAGE
+           || expected_status == LL_STATUS_NO_ENOUGH_BYTES
+           || expected_remainder == 0)
+        {
+            break;
+        }
+        position += expected_remainder;
+    }
+    free(expected);
+    free(parsed);
+}
+
+static void ll_protocol_test_decoder(ll_message_info_t msg_info, bool noisy, uint8_t* stream,
+                                     uint8_t* messages)
+{
+    size_t messages_count;
+    size_t size = ll_protocol_test_stream(msg_info, noisy, stream, messages, &messages_count);
+    uint8_t* buffer = malloc(msg_info.size + 1);
+    uint8_t* pushed = malloc(msg_info.size + 1);
+    ll_decoder_t decoder;
+    ll_decoder_t runs;
+    ll_protocol_test_check(   ll_decoder_init(&decoder, msg_info, buffer) == LL_STATUS_SUCCESS
+                           && ll_decoder_init(&runs, msg_info, pushed) == LL_STATUS_SUCCESS,
+                           "decoder is initialized");
+
+    //decoder which gets bytes one by one and decoder which gets runs must be in the same state
+    size_t next = 0;
+    size_t unknown = 0;
+    size_t position = 0;
+    while(position < size)
+    {
+        size_t run = 1 + ll_protocol_test_random() % 64;
+        if(run > size - position)
+        {
+            run = size - position;
+        }
+        size_t consumed = 0;
+        bool pushed_parsed = ll_decoder_push(&runs, stream + position, run, &consumed);
+        for(size_t i = 0; i < consumed; i++)
+        {
+            bool parsed = ll_decoder_push_byte(&decoder, stream[position + i]);
+            if(i + 1 < consumed)
+            {
+                ll_protocol_test_check(!parsed, "message is not parsed inside of run");
+                continue;
+            }
+            ll_protocol_test_check(parsed == pushed_parsed && decoder.status == runs.status,
+                                   "run is parsed as bytes");
+            if(!parsed)
+            {
+                continue;
+            }
+            ll_protocol_test_check(memcmp(buffer, pushed, msg_info.size) == 0,
+                                   "message of run is the same as message of bytes");
+            //sent messages come in order, messages can be lost only in noisy stream
+            size_t found = next;
+            while(   found < messages_count
+                  && memcmp(buffer, messages + found * msg_info.size, msg_info.size) != 0)
+            {
+                found++;
+            }
+            ll_protocol_test_check(noisy || found == next, "decoder gives the next message");
+            if(found == messages_count)
+            {
+                unknown++;
+            }
+            else
+            {
+                next = found + 1;
+            }
+        }
+        position += consumed;
+    }
+    if(!noisy)
+    {
+        ll_protocol_test_check(next == messages_count && unknown == 0, "decoder gives all messages");
+    }
+    else if(msg_info.checksum == LL_CHECKSUM_CRC32C)
+    {
+        ll_protocol_test_check(unknown == 0, "decoder gives only sent messages");
+    }
+    free(buffer);
+    free(pushed);
+}
+
+int main(void)
+{
+    ll_protocol_test_crc32c();
+
+    const size_t sizes[] = {0, 1, 2, 3, 7, 64, 250, 253, 254, 255, 300, 508, 1000};
+    uint8_t* stream = malloc(LL_PROTOCOL_TEST_STREAM);
+    uint8_t* messages = malloc(LL_PROTOCOL_TEST_MESSAGES * 1000);
+    for(int framing = 0; framing < LL_FRAMING_ENUM_SIZE; framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+            {
+                ll_message_info_t msg_info = ll_protocol_test_info(sizes[i], framing, checksum);
+                ll_protocol_test_check(ll_message_info_valid(msg_info), "message info is valid");
+                ll_protocol_test_round_trip(msg_info);
+            }
+            for(int iteration = 0; iteration < 50; iteration++)
+            {
+                size_t size = iteration % 10 ? ll_protocol_test_random() % 40 : ll_protocol_test_random() % 1000;
+                ll_message_info_t msg_info = ll_protocol_test_info(size, framing, checksum);
+                ll_protocol_test_stream_equivalence(msg_info, stream, messages);
+                ll_protocol_test_decoder(msg_info, false, stream, messages);
+                ll_protocol_test_decoder(msg_info, true, stream, messages);
+            }
+        }
+    }
+    free(stream);
+    free(messages);
+
+    //control bytes which can't be used in LL_FRAMING_XOR mode ("begin byte" ^ 0x20 is "end byte")
+    ll_message_info_t msg_info = ll_protocol_test_info(4, LL_FRAMING_XOR, LL_CHECKSUM_NONE);
+    msg_info.end_byte = 0x5E;
+    uint8_t data[4] = {0};
+    size_t remainder;
+    ll_protocol_test_check(!ll_message_info_valid(msg_info), "XOR control bytes are not valid");
+    ll_protocol_test_check(ll_deserialize(msg_info, data, sizeof(data), data, &remainder)
+                           == LL_STATUS_BAD_PARAMS, "XOR control bytes are rejected");
+
+    if(failures)
+    {
+        fprintf(stderr, "ll_protocol_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_protocol_test: OK\n");
+    return 0;
+}
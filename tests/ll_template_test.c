@@ -0,0 +1,135 @@
+/*
+    Template cache: every frame given by cache must be the same as frame serialized
+from message, also for messages which differ in one byte and when entries are replaced,
+in all framings, with and without checksum, for messages of size 0 and bigger.
+
+Build: cmake -S . -B build && cmake --build build && ctest --test-dir build
+*/
+
+#include "ll_template.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LL_TEMPLATE_TEST_POOL 40
+#define LL_TEMPLATE_TEST_LOOKUPS 20000
+
+
+static int failures = 0;
+static uint64_t random_state = 13;
+
+static void ll_template_test_check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        if(failures < 20)
+        {
+            fprintf(stderr, "FAILED: %s\n", what);
+        }
+        failures++;
+    }
+}
+
+static uint32_t ll_template_test_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (uint32_t)random_state;
+}
+
+static void ll_template_test_cache(ll_message_info_t msg_info)
+{
+    //memory for 16 entries, so pool doesn't fit into cache and entries are replaced
+    size_t slot_size = msg_info.size + ll_sizeof_serialized_max(msg_info) + 8;
+    ll_template_cache_t cache;
+    if(ll_template_cache_init(&cache, msg_info, 16 * (slot_size + sizeof(ll_template_entry_t))) != LL_STATUS_SUCCESS)
+    {
+        ll_template_test_check(false, "cache is initialized");
+        return;
+    }
+
+    //messages of pool differ from each other in one byte
+    uint8_t* pool = malloc(LL_TEMPLATE_TEST_POOL * msg_info.size + 1);
+    for(size_t i = 0; i < LL_TEMPLATE_TEST_POOL * msg_info.size; i++)
+    {
+        pool[i] = i < msg_info.size ? (uint8_t)(0x7C + ll_template_test_random() % 4) : pool[i - msg_info.size];
+    }
+    for(size_t i = 1; i < LL_TEMPLATE_TEST_POOL && msg_info.size; i++)
+    {
+        pool[i * msg_info.size + ll_template_test_random() % msg_info.size] ^= (uint8_t)(1 + ll_template_test_random() % 255);
+    }
+
+    uint8_t* expected = malloc(ll_sizeof_serialized_max(msg_info));
+    uint8_t* cached = malloc(ll_sizeof_serialized_max(msg_info));
+    for(int lookup = 0; lookup < LL_TEMPLATE_TEST_LOOKUPS; lookup++)
+    {
+        //half of lookups is for few messages which stay in cache
+        size_t index = ll_template_test_random() % (lookup % 2 ? 4 : LL_TEMPLATE_TEST_POOL);
+        const uint8_t* message = pool + index * msg_info.size;
+        size_t expected_size = ll_serialize(msg_info, message, expected);
+        size_t cached_size = ll_template_serialize(&cache, message, cached);
+        if(cached_size != expected_size || memcmp(cached, expected, expected_size) != 0)
+        {
+            ll_template_test_check(false, "cached frame is serialized message");
+            break;
+        }
+    }
+
+    size_t size = 0;
+    const uint8_t* frame = ll_template_get(&cache, pool, &size);
+    uint64_t hits = cache.hits;
+    frame = ll_template_get(&cache, pool, &size);
+    ll_template_test_check(   frame && cache.hits == hits + 1
+                           && cache.hits + cache.misses == LL_TEMPLATE_TEST_LOOKUPS + 2,
+                           "repeated message is taken from cache");
+    ll_template_test_check(ll_template_get(&cache, NULL, &size) == NULL, "message NULL is rejected");
+
+    ll_template_cache_destroy(&cache);
+    free(pool);
+    free(expected);
+    free(cached);
+}
+
+int main(void)
+{
+    const size_t sizes[] = {0, 1, 7, 37, 300};
+    for(int framing = 0; framing < LL_FRAMING_ENUM_SIZE; framing++)
+    {
+        for(int checksum = 0; checksum < LL_CHECKSUM_ENUM_SIZE; checksum++)
+        {
+            for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+            {
+                ll_message_info_t msg_info;
+                memset(&msg_info, 0, sizeof(msg_info));
+                msg_info.size = sizes[i];
+                msg_info.begin_byte = 0x7E;
+                msg_info.reject_byte = 0x7D;
+                msg_info.end_byte = framing == LL_FRAMING_REJECT ? 0x7C : 0x7F;
+                msg_info.framing = (ll_framing_t)framing;
+                msg_info.checksum = (ll_checksum_t)checksum;
+                ll_template_test_cache(msg_info);
+            }
+        }
+    }
+
+    //memory is less than one group of entries
+    ll_message_info_t msg_info;
+    memset(&msg_info, 0, sizeof(msg_info));
+    msg_info.size = 37;
+    msg_info.begin_byte = 0x7E;
+    msg_info.reject_byte = 0x7D;
+    msg_info.end_byte = 0x7C;
+    ll_template_cache_t cache;
+    ll_template_test_check(ll_template_cache_init(&cache, msg_info, 100) == LL_STATUS_BAD_PARAMS,
+                           "too small cache is rejected");
+
+    if(failures)
+    {
+        fprintf(stderr, "ll_template_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("ll_template_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,596 @@
+/*
+    Decoder of link captures: file with raw byte stream received from the link.
+
+    Capture is mapped to memory with mmap, so there are no copies from page cache
+to user buffers and no chunk boundaries where remainder must be parsed again.
+Whole file is parsed by ll_deserialize_all (or ll_deserialize_parallel with
+--threads) in one call. Kernel is asked to read the file ahead (MADV_SEQUENTIAL),
+--populate maps all pages before parsing (MAP_POPULATE) and --hugepages asks
+kernel to use transparent huge pages for the mapping (MADV_HUGEPAGE) which reduces
+TLB misses if file system supports it.
+
+    Parsed messages (LL_STATUS_SUCCESS only) are written one after another to
+--output file, without it messages are only counted (frames are found by ll_scan_all
+which validates them without copying). Quantity of every status,
+size of uncompleted message at the end of capture and throughput are printed
+to stdout.
+
+    With --match only messages with given first bytes (option can be repeated) are
+unescaped fully and written to --output, other frames are only validated (see
+ll_deserialize_filtered), quantity of matched messages is printed.
+
+    With --index the same pass writes index of frames (see ll_index.h). With --frame
+and --index only frame N is read from capture using existing index (message info
+is taken from index) and its status and bytes in hex are printed.
+
+    With --replay CAPTURE is capture file with timestamped chunks (see ll_capture.h)
+which is replayed through ll_decoder_push by the same chunks as they were received,
+as fast as possible or in real time. Time spent in decoder and percentiles of time
+from push of chunk to parsed message are printed.
+
+Build (from repository root, target "ll_decode"):
+    cmake -S . -B build && cmake --build build --target ll_decode
+
+Usage:
+    ll_decode --size BYTES [--begin BYTE] [--reject BYTE] [--end BYTE]
+              [--framing reject|cobs|xor] [--checksum none|crc32c]
+              [--threads N] [--populate] [--hugepages] [--output FILE]
+              [--match BYTE]... [--index FILE] CAPTURE
+    ll_decode --index FILE --frame N CAPTURE
+    ll_decode --size BYTES [message info options] --replay fast|realtime [--output FILE] CAPTURE
+*/
+
+#define _GNU_SOURCE
+
+#include "ll_protocol.h"
+#include "ll_parallel.h"
+#include "ll_index.h"
+#include "ll_capture.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LL_DECODE_BEGIN_BYTE  0xAA
+#define LL_DECODE_REJECT_BYTE 0xCC
+#define LL_DECODE_END_BYTE    0xBB
+
+//buffer of output file, messages are small so they are written by big blocks
+#define LL_DECODE_OUTPUT_BUFFER ((size_t)1024 * 1024)
+
+
+typedef struct
+{
+    FILE*              output;
+    ll_index_writer_t* index;
+    size_t             size;
+    uint64_t           statuses[LL_STATUS_ENUM_SIZE];
+    uint64_t           matched; //quantity of messages matched by --match
+    bool               failed;  //writing to output has failed
+} ll_decode_t;
+
+static const char* ll_decode_status_names[LL_STATUS_ENUM_SIZE] =
+{
+    "success",
+    "bad_params",
+    "no_message",
+    "no_enough_bytes",
+    "message_too_short",
+    "message_too_long",
+    "checksum_failure",
+    "no_reference"
+};
+
+static double ll_decode_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void ll_decode_frame(void* context, ll_status_t status, size_t position, const uint8_t* data)
+{
+    ll_decode_t* decode = (ll_decode_t*)context;
+    decode->statuses[status]++;
+    if(decode->index)
+    {
+        ll_index_writer_add(decode->index, status, position, data);
+    }
+
+    //data is NULL for messages which are not matched by --match
+    if(status == LL_STATUS_SUCCESS && data)
+    {
+        decode->matched++;
+    }
+    if(status == LL_STATUS_SUCCESS && data && decode->output && !decode->failed)
+    {
+        if(fwrite(data, 1, decode->size, decode->output) != decode->size)
+        {
+            decode->failed = true;
+        }
+    }
+}
+
+static void ll_decode_scan(void* context, ll_status_t status, size_t position, const ll_frame_scan_t* frame)
+{
+    (void)frame;
+    ll_decode_t* decode = (ll_decode_t*)context;
+    decode->statuses[status]++;
+    if(decode->index)
+    {
+        ll_index_writer_add(decode->index, status, position, NULL);
+    }
+}
+
+static bool ll_decode_byte(const char* text, uint8_t* byte)
+{
+    char* end;
+    unsigned long value = strtoul(text, &end, 0);
+    if(*text == '\0' || *end != '\0' || value > 0xFF)
+    {
+        return false;
+    }
+    *byte = (uint8_t)value;
+    return true;
+}
+
+static void ll_decode_message(void* context, const uint8_t* data)
+{
+    ll_decode_frame(context, LL_STATUS_SUCCESS, 0, data);
+}
+
+static int ll_decode_replay(ll_message_info_t msg_info,
+                            ll_capture_replay_t mode,
+                            const char* capture_path,
+                            const char* output_path)
+{
+    ll_capture_reader_t reader;
+    if(ll_capture_reader_open(&reader, capture_path) != LL_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "%s: can't open capture\n", capture_path);
+        return 1;
+    }
+
+    ll_decode_t decode;
+    memset(&decode, 0, sizeof(decode));
+    decode.size = msg_info.size;
+    if(output_path)
+    {
+        decode.output = fopen(output_path, "wb");
+        if(!decode.output)
+        {
+            fprintf(stderr, "%s: %s\n", output_path, strerror(errno));
+            ll_capture_reader_close(&reader);
+            return 1;
+        }
+        setvbuf(decode.output, NULL, _IOFBF, LL_DECODE_OUTPUT_BUFFER);
+    }
+
+    int result = 0;
+    uint8_t* data = malloc(msg_info.size);
+    ll_latency_histogram_t* histogram = malloc(sizeof(*histogram));
+    ll_decoder_t decoder;
+    ll_capture_stats_t stats;
+    if(!data || !histogram || ll_decoder_init(&decoder, msg_info, data) != LL_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "%s: bad message info\n", capture_path);
+        result = 1;
+    }
+    else
+    {
+        ll_latency_histogram_init(histogram);
+        if(ll_capture_replay(&reader, &decoder, mode, histogram, ll_decode_message, &decode, &stats)
+           != LL_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "%s: capture is corrupted, replay is stopped\n", capture_path);
+            result = 1;
+        }
+    }
+    if(decode.output)
+    {
+        if(fclose(decode.output) != 0)
+        {
+            decode.failed = true;
+        }
+        if(decode.failed)
+        {
+            fprintf(stderr, "%s: %s\n", output_path, strerror(errno));
+            result = 1;
+        }
+    }
+
+    if(result == 0)
+    {
+        ll_latency_snapshot_t* snapshot = malloc(sizeof(*snapshot));
+        if(snapshot)
+        {
+            ll_latency_snapshot(histogram, snapshot);
+        }
+        double seconds = (double)stats.decode_ns * 1e-9;
+        printf("%-18s %llu\n", "success", (unsigned long long)stats.messages);
+        printf("%-18s %llu\n", "chunks", (unsigned long long)stats.chunks);
+        printf("%-18s %llu\n", "capture_bytes", (unsigned long long)stats.bytes);
+        printf("%-18s %.6f\n", "seconds", (double)stats.elapsed_ns * 1e-9);
+        printf("%-18s %.6f\n", "decode_seconds", seconds);
+        printf("%-18s %.1f\n", "mb_per_second", seconds > 0 ? (double)stats.bytes / seconds / 1e6 : 0.0);
+        printf("%-18s %llu\n", "late_max_ns", (unsigned long long)stats.late_max_ns);
+        printf("%-18s %llu\n", "latency_p50_ns", (unsigned long long)ll_latency_percentile(snapshot, 50.0));
+        printf("%-18s %llu\n", "latency_p99_ns", (unsigned long long)ll_latency_percentile(snapshot, 99.0));
+        printf("%-18s %llu\n", "latency_p999_ns", (unsigned long long)ll_latency_percentile(snapshot, 99.9));
+        free(snapshot);
+    }
+
+    free(histogram);
+    free(data);
+    ll_capture_reader_close(&reader);
+    return result;
+}
+
+static int ll_decode_frame_by_index(const char* index_path, const char* capture_path, uint64_t frame)
+{
+    ll_index_t index;
+    if(ll_index_open(&index, index_path) != LL_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "%s: can't open index\n", index_path);
+        return 1;
+    }
+    int fd = open(capture_path, O_RDONLY);
+    if(fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", capture_path, strerror(errno));
+        ll_index_close(&index);
+        return 1;
+    }
+
+    int result = 0;
+    uint8_t* data = malloc(index.msg_info.size ? index.msg_info.size : 1);
+    ll_status_t status = data ? ll_index_read(&index, fd, frame, data) : LL_STATUS_BAD_PARAMS;
+    if(status == LL_STATUS_BAD_PARAMS)
+    {
+        fprintf(stderr, "%s: frame %llu can't be read (index has %llu frames)\n",
+                capture_path, (unsigned long long)frame, (unsigned long long)index.frames);
+        result = 1;
+    }
+    else
+    {
+        printf("%s", ll_decode_status_names[status]);
+        if(status == LL_STATUS_SUCCESS || status == LL_STATUS_CHECKSUM_FAILURE)
+        {
+            printf(" ");
+            for(size_t i = 0; i < index.msg_info.size; i++)
+            {
+                printf("%02x", data[i]);
+            }
+        }
+        printf("\n");
+    }
+
+    free(data);
+    close(fd);
+    ll_index_close(&index);
+    return result;
+}
+
+static void ll_decode_usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s --size BYTES [--begin BYTE] [--reject BYTE] [--end BYTE]\n"
+            "       [--framing reject|cobs|xor] [--checksum none|crc32c]\n"
+            "       [--threads N] [--populate] [--hugepages] [--output FILE]\n"
+            "       [--match BYTE]... [--index FILE] CAPTURE\n"
+            "       %s --index FILE --frame N CAPTURE\n"
+            "       %s --size BYTES [message info options] --replay fast|realtime [--output FILE] CAPTURE\n",
+            name, name, name);
+}
+
+int main(int argc, char** argv)
+{
+    ll_message_info_t msg_info =
+    {
+        0,
+        LL_DECODE_BEGIN_BYTE,
+        LL_DECODE_REJECT_BYTE,
+        LL_DECODE_END_BYTE,
+        LL_FRAMING_REJECT,
+        LL_CHECKSUM_NONE
+    };
+    size_t threads = 1;
+    bool populate = false;
+    bool hugepages = false;
+    const char* output_path = NULL;
+    const char* index_path = NULL;
+    const char* frame = NULL;
+    int replay = -1;
+    const char* capture_path = NULL;
+    ll_filter_t filter;
+    bool filtering = false;
+    memset(&filter, 0, sizeof(filter));
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool ok = true;
+        if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            msg_info.size = strtoull(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "--begin") == 0 && i + 1 < argc)
+        {
+            ok = ll_decode_byte(argv[++i], &msg_info.begin_byte);
+        }
+        else if(strcmp(argv[i], "--reject") == 0 && i + 1 < argc)
+        {
+            ok = ll_decode_byte(argv[++i], &msg_info.reject_byte);
+        }
+        else if(strcmp(argv[i], "--end") == 0 && i + 1 < argc)
+        {
+            ok = ll_decode_byte(argv[++i], &msg_info.end_byte);
+        }
+        else if(strcmp(argv[i], "--framing") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "reject") == 0)
+            {
+                msg_info.framing = LL_FRAMING_REJECT;
+            }
+            else if(strcmp(argv[i], "cobs") == 0)
+            {
+                msg_info.framing = LL_FRAMING_COBS;
+            }
+            else if(strcmp(argv[i], "xor") == 0)
+            {
+                msg_info.framing = LL_FRAMING_XOR;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        else if(strcmp(argv[i], "--checksum") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "none") == 0)
+            {
+                msg_info.checksum = LL_CHECKSUM_NONE;
+            }
+            else if(strcmp(argv[i], "crc32c") == 0)
+            {
+                msg_info.checksum = LL_CHECKSUM_CRC32C;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = strtoull(argv[++i], NULL, 0);
+        }
+        else if(strcmp(argv[i], "--populate") == 0)
+        {
+            populate = true;
+        }
+        else if(strcmp(argv[i], "--hugepages") == 0)
+        {
+            hugepages = true;
+        }
+        else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--match") == 0 && i + 1 < argc)
+        {
+            uint8_t byte = 0;
+            ok = ll_decode_byte(argv[++i], &byte);
+            ll_filter_add_first_byte(&filter, byte);
+            filtering = true;
+        }
+        else if(strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+        {
+            index_path = argv[++i];
+        }
+        else if(strcmp(argv[i], "--frame") == 0 && i + 1 < argc)
+        {
+            frame = argv[++i];
+        }
+        else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            i++;
+            if(strcmp(argv[i], "fast") == 0)
+            {
+                replay = LL_CAPTURE_REPLAY_FAST;
+            }
+            else if(strcmp(argv[i], "realtime") == 0)
+            {
+                replay = LL_CAPTURE_REPLAY_REALTIME;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        else if(argv[i][0] != '-' && !capture_path)
+        {
+            capture_path = argv[i];
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if(!ok)
+        {
+            ll_decode_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(capture_path && frame && index_path)
+    {
+        return ll_decode_frame_by_index(index_path, capture_path, strtoull(frame, NULL, 0));
+    }
+    //filter is supported only by one pass in the calling thread
+    if(!capture_path || frame || msg_info.size == 0 || (filtering && (threads != 1 || replay >= 0)))
+    {
+        ll_decode_usage(argv[0]);
+        return 1;
+    }
+    if(replay >= 0)
+    {
+        return ll_decode_replay(msg_info, (ll_capture_replay_t)replay, capture_path, output_path);
+    }
+
+    int fd = open(capture_path, O_RDONLY);
+    if(fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", capture_path, strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", capture_path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+    size_t capture_size = (size_t)st.st_size;
+
+    //mmap of empty file fails, empty capture is parsed as empty byte stream
+    const uint8_t* capture = NULL;
+    if(capture_size > 0)
+    {
+        void* mapping = mmap(NULL, capture_size, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            fprintf(stderr, "%s: %s\n", capture_path, strerror(errno));
+            close(fd);
+            return 1;
+        }
+        capture = (const uint8_t*)mapping;
+
+        //advices are only hints, errors are ignored
+        madvise(mapping, capture_size, threads == 1 ? MADV_SEQUENTIAL : MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+        if(hugepages)
+        {
+            madvise(mapping, capture_size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    close(fd);
+
+    ll_decode_t decode;
+    memset(&decode, 0, sizeof(decode));
+    decode.size = msg_info.size;
+    if(output_path)
+    {
+        decode.output = fopen(output_path, "wb");
+        if(!decode.output)
+        {
+            fprintf(stderr, "%s: %s\n", output_path, strerror(errno));
+            if(capture)
+            {
+                munmap((void*)capture, capture_size);
+            }
+            return 1;
+        }
+        setvbuf(decode.output, NULL, _IOFBF, LL_DECODE_OUTPUT_BUFFER);
+    }
+    ll_index_writer_t index;
+    if(index_path)
+    {
+        if(ll_index_writer_open(&index, msg_info, index_path) != LL_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "%s: %s\n", index_path, strerror(errno));
+            if(decode.output)
+            {
+                fclose(decode.output);
+            }
+            if(capture)
+            {
+                munmap((void*)capture, capture_size);
+            }
+            return 1;
+        }
+        decode.index = &index;
+    }
+
+    //empty byte stream is passed as non NULL pointer, NULL means bad parameters
+    static const uint8_t empty[1];
+    size_t remainder = 0;
+    double begin = ll_decode_seconds();
+    const uint8_t* stream = capture ? capture : empty;
+    ll_status_t status;
+    if(filtering)
+    {
+        status = ll_deserialize_filtered_all(msg_info, &filter, stream, capture_size, ll_decode_frame, &decode, &remainder);
+    }
+    else if(threads != 1)
+    {
+        status = ll_deserialize_parallel(msg_info, stream, capture_size, threads, ll_decode_frame, &decode, &remainder);
+    }
+    else if(decode.output)
+    {
+        status = ll_deserialize_all(msg_info, stream, capture_size, ll_decode_frame, &decode, &remainder);
+    }
+    else
+    {
+        //messages are not needed, frames are only validated
+        status = ll_scan_all(msg_info, stream, capture_size, ll_decode_scan, &decode, &remainder);
+    }
+    double seconds = ll_decode_seconds() - begin;
+
+    int result = 0;
+    if(status == LL_STATUS_BAD_PARAMS)
+    {
+        fprintf(stderr, "%s: can't parse capture (bad message info or no memory for threads)\n", capture_path);
+        result = 1;
+    }
+    if(decode.index && ll_index_writer_close(decode.index, remainder) != LL_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "%s: can't write index\n", index_path);
+        remove(index_path);
+        result = 1;
+    }
+    if(decode.output)
+    {
+        if(fclose(decode.output) != 0)
+        {
+            decode.failed = true;
+        }
+        if(decode.failed)
+        {
+            fprintf(stderr, "%s: %s\n", output_path, strerror(errno));
+            result = 1;
+        }
+    }
+    if(capture)
+    {
+        munmap((void*)capture, capture_size);
+    }
+    if(result != 0)
+    {
+        return result;
+    }
+
+    for(int i = 0; i < LL_STATUS_ENUM_SIZE; i++)
+    {
+        if(i != LL_STATUS_BAD_PARAMS && i != LL_STATUS_NO_MESSAGE && i != LL_STATUS_NO_ENOUGH_BYTES)
+        {
+            printf("%-18s %llu\n", ll_decode_status_names[i], (unsigned long long)decode.statuses[i]);
+        }
+    }
+    if(filtering)
+    {
+        printf("%-18s %llu\n", "matched", (unsigned long long)decode.matched);
+    }
+    printf("%-18s %zu\n", "uncompleted_bytes", capture_size - remainder);
+    printf("%-18s %zu\n", "capture_bytes", capture_size);
+    printf("%-18s %.6f\n", "seconds", seconds);
+    printf("%-18s %.1f\n", "mb_per_second", seconds > 0 ? (double)capture_size / seconds / 1e6 : 0.0);
+    return 0;
+}